@@ -0,0 +1,106 @@
+#include "bulk_transfer.h"
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace BulkTransfer {
+
+Format formatOf(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".csv" ? Format::Csv : Format::Ndjson;
+}
+
+void Report::addError(size_t recordNumber, const std::string& message) {
+    ++failed;
+    if (errors.size() < MAX_REPORTED_ERRORS) {
+        errors.push_back("第" + std::to_string(recordNumber) + "条: " + message);
+    }
+}
+
+bool BlockReader::open(const std::string& path, std::string& error) {
+    file_.open(path, std::ios::binary);
+    if (!file_) {
+        error = "无法打开文件: " + path;
+        return false;
+    }
+    std::error_code ec;
+    totalBytes_ = std::filesystem::file_size(path, ec);
+    
+    // 跳过UTF-8 BOM（表格软件导出的CSV常带）
+    char bom[3];
+    if (!file_.read(bom, 3) || std::memcmp(bom, "\xEF\xBB\xBF", 3) != 0) {
+        file_.clear();
+        file_.seekg(0);
+    } else {
+        bytesRead_ = 3;
+    }
+    return true;
+}
+
+size_t BlockReader::lastRecordEnd(std::string_view text) const {
+    if (format_ == Format::Ndjson) {
+        // JSON字符串里的换行必须转义，所以最后一个换行就是记录边界
+        size_t newline = text.rfind('\n');
+        return newline == std::string_view::npos ? 0 : newline + 1;
+    }
+    // CSV的换行可能在引号内，只能从块首顺序判断
+    size_t end = 0;
+    for (size_t next; (next = Csv::findRecordEnd(text, end)) != std::string_view::npos;) {
+        end = next;
+    }
+    return end;
+}
+
+bool BlockReader::next(std::string& block) {
+    block.swap(carry_);
+    carry_.clear();
+    while (true) {
+        size_t offset = block.size();
+        block.resize(offset + BLOCK_SIZE);
+        file_.read(block.data() + offset, BLOCK_SIZE);
+        size_t got = static_cast<size_t>(file_.gcount());
+        block.resize(offset + got);
+        bytesRead_ += got;
+        
+        if (got == 0) {
+            // 文件结束：剩下的内容（可能没有结尾换行）就是最后一块
+            return !block.empty();
+        }
+        size_t end = lastRecordEnd(block);
+        if (end > 0) {
+            carry_.assign(block, end, std::string::npos);
+            block.resize(end);
+            return true;
+        }
+        // 一整块都不够一条记录，继续读
+    }
+}
+
+void splitRecords(std::string_view block, Format format, std::vector<std::string_view>& records) {
+    records.clear();
+    size_t pos = 0;
+    while (pos < block.length()) {
+        size_t end = format == Format::Csv ? Csv::findRecordEnd(block, pos) : block.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = block.length();
+        } else if (format == Format::Ndjson) {
+            ++end;
+        }
+        std::string_view record = block.substr(pos, end - pos);
+        pos = end;
+        if (record.find_first_not_of(" \t\r\n") != std::string_view::npos) {
+            records.push_back(record);
+        }
+    }
+}
+
+namespace detail {
+
+unsigned hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+} // namespace detail
+
+} // namespace BulkTransfer
@@ -0,0 +1,251 @@
+#ifndef BULK_TRANSFER_H
+#define BULK_TRANSFER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <algorithm>
+#include <cstdint>
+#include "json_codec.h"
+#include "csv_codec.h"
+
+// 流式批量导入/导出：NDJSON（每行一个JSON对象）或CSV（首行为表头），字段同 jsonFields()。
+//
+// 导入时按块读文件（每块约BLOCK_SIZE字节，块尾对齐到完整记录），每块内的记录分给多个线程解析，
+// 再按文件顺序逐条交给调用方，因此内存占用只与块大小有关，与文件大小无关，也不构造 Json::Value。
+// 导出时边遍历边序列化，缓冲区满BLOCK_SIZE就写出。
+namespace BulkTransfer {
+
+enum class Format { Ndjson, Csv };
+
+// 按扩展名判断：.csv为CSV，其他（.ndjson/.jsonl等）为NDJSON
+Format formatOf(const std::string& path);
+
+constexpr size_t BLOCK_SIZE = 4 << 20;
+// 每个线程至少解析这么多条记录，块内记录太少时不值得开线程
+constexpr size_t MIN_RECORDS_PER_THREAD = 2048;
+// 报告中最多保留的错误条数，其余只计数
+constexpr size_t MAX_REPORTED_ERRORS = 100;
+
+struct Progress {
+    size_t records = 0;        // 已处理的记录（导入时含失败的）
+    uint64_t bytes = 0;        // 已读入或写出的字节
+    uint64_t totalBytes = 0;   // 导入时为文件大小，导出时为0
+    size_t totalRecords = 0;   // 导出时为记录总数，导入时为0
+    
+    double fraction() const {
+        if (totalBytes > 0) return static_cast<double>(bytes) / totalBytes;
+        if (totalRecords > 0) return static_cast<double>(records) / totalRecords;
+        return 0.0;
+    }
+};
+
+// 每处理完一块调用一次
+using ProgressHook = std::function<void(const Progress&)>;
+
+struct Report {
+    size_t succeeded = 0;
+    size_t failed = 0;
+    std::vector<std::string> errors; // "第N条: 原因"，最多MAX_REPORTED_ERRORS条
+    std::string fatal;               // 文件无法打开、表头损坏等整体失败的原因
+    
+    bool ok() const { return fatal.empty(); }
+    void addError(size_t recordNumber, const std::string& message);
+};
+
+// 顺序读取文件，每次给出以完整记录结尾的一块；跨块的半条记录留到下一块
+class BlockReader {
+public:
+    explicit BlockReader(Format format) : format_(format) {}
+    
+    bool open(const std::string& path, std::string& error);
+    // 读出下一块，文件读完时返回false。单条记录超过BLOCK_SIZE时块会相应变大
+    bool next(std::string& block);
+    
+    uint64_t bytesRead() const { return bytesRead_; }
+    uint64_t totalBytes() const { return totalBytes_; }
+
+private:
+    size_t lastRecordEnd(std::string_view text) const;
+    
+    Format format_;
+    std::ifstream file_;
+    std::string carry_;
+    uint64_t bytesRead_ = 0;
+    uint64_t totalBytes_ = 0;
+};
+
+// 把一块切成记录（视图指向block），跳过空行
+void splitRecords(std::string_view block, Format format, std::vector<std::string_view>& records);
+
+namespace detail {
+
+unsigned hardwareThreads();
+
+// 解析一条记录；失败时返回nullptr并填写error
+template <typename T>
+std::unique_ptr<T> parseRecord(std::string_view record, Format format, const std::vector<int>& binding,
+                               std::vector<std::string>& cells, std::string& error) {
+    auto obj = std::make_unique<T>();
+    try {
+        if (format == Format::Ndjson) {
+            Json::Scanner in(record);
+            Json::readObject(in, *obj);
+            if (!in.atEnd()) {
+                throw std::runtime_error("对象之后有多余内容");
+            }
+        } else {
+            Csv::splitRecord(record, cells);
+            Csv::readRow(cells, binding, *obj);
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        return nullptr;
+    }
+    return obj;
+}
+
+} // namespace detail
+
+// 流式导入：逐块读入并行解析，按文件顺序对每个实体调用 sink(std::unique_ptr<T>)。
+// sink返回空串表示接受，否则返回拒绝原因（计入失败）。sink只在调用线程上执行
+template <typename T, typename Sink>
+Report importFile(const std::string& path, Sink&& sink, const ProgressHook& progress = {},
+                  unsigned maxThreads = detail::hardwareThreads()) {
+    Report report;
+    Format format = formatOf(path);
+    BlockReader reader(format);
+    if (!reader.open(path, report.fatal)) {
+        return report;
+    }
+    
+    std::string block;
+    std::vector<std::string_view> records;
+    std::vector<int> binding;    // CSV表头绑定，读到第一条记录时建立
+    bool needHeader = format == Format::Csv;
+    size_t recordNumber = 0;     // 已处理的数据记录数（不含表头），报错时用于定位
+    
+    while (reader.next(block)) {
+        splitRecords(block, format, records);
+        size_t first = 0;
+        if (needHeader && !records.empty()) {
+            std::vector<std::string> header;
+            try {
+                Csv::splitRecord(records.front(), header);
+            } catch (const std::exception& e) {
+                report.fatal = std::string("CSV表头损坏: ") + e.what();
+                return report;
+            }
+            binding = Csv::bindHeader<T>(header);
+            needHeader = false;
+            first = 1;
+        }
+        
+        // 按记录区间切分给各线程，每个线程只写自己区间内的结果
+        size_t count = records.size() - first;
+        std::vector<std::unique_ptr<T>> parsed(count);
+        std::vector<std::string> errors(count);
+        auto parseRange = [&](size_t begin, size_t end) {
+            std::vector<std::string> cells;
+            for (size_t i = begin; i < end; ++i) {
+                parsed[i] = detail::parseRecord<T>(records[first + i], format, binding, cells, errors[i]);
+            }
+        };
+        size_t threads = std::clamp<size_t>(count / MIN_RECORDS_PER_THREAD, 1, std::max(1u, maxThreads));
+        size_t chunk = (count + threads - 1) / threads;
+        std::vector<std::future<void>> tasks;
+        for (size_t t = 1; t < threads; ++t) {
+            size_t begin = std::min(count, t * chunk);
+            tasks.push_back(std::async(std::launch::async, parseRange, begin, std::min(count, begin + chunk)));
+        }
+        parseRange(0, std::min(count, chunk));
+        for (auto& task : tasks) {
+            task.get();
+        }
+        
+        for (size_t i = 0; i < count; ++i) {
+            ++recordNumber;
+            if (!parsed[i]) {
+                report.addError(recordNumber, errors[i]);
+                continue;
+            }
+            std::string rejected = sink(std::move(parsed[i]));
+            if (rejected.empty()) {
+                ++report.succeeded;
+            } else {
+                report.addError(recordNumber, rejected);
+            }
+        }
+        
+        if (progress) {
+            Progress state;
+            state.records = recordNumber;
+            state.bytes = reader.bytesRead();
+            state.totalBytes = reader.totalBytes();
+            progress(state);
+        }
+    }
+    return report;
+}
+
+// 流式导出：add()把实体序列化到缓冲区，缓冲区满时写出到文件
+template <typename T>
+class Exporter {
+public:
+    Exporter(const std::string& path, size_t totalRecords, ProgressHook progress = {})
+        : format_(formatOf(path)), file_(path, std::ios::binary | std::ios::trunc), progress_(std::move(progress)) {
+        state_.totalRecords = totalRecords;
+        buffer_.reserve(BLOCK_SIZE + 4096);
+        if (format_ == Format::Csv) {
+            Csv::writeHeader<T>(buffer_);
+        }
+    }
+    
+    bool isOpen() const { return file_.is_open(); }
+    
+    void add(const T& obj) {
+        if (format_ == Format::Ndjson) {
+            Json::writeObject(buffer_, obj);
+            buffer_ += '\n';
+        } else {
+            Csv::writeRow(buffer_, obj);
+        }
+        ++state_.records;
+        if (buffer_.size() >= BLOCK_SIZE) {
+            flush();
+        }
+    }
+    
+    // 写出剩余内容；任何一次写入失败都返回false
+    bool finish() {
+        flush();
+        file_.close();
+        return !file_.fail();
+    }
+    
+    size_t records() const { return state_.records; }
+
+private:
+    void flush() {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        state_.bytes += buffer_.size();
+        buffer_.clear();
+        if (progress_) {
+            progress_(state_);
+        }
+    }
+    
+    Format format_;
+    std::ofstream file_;
+    std::string buffer_;
+    Progress state_;
+    ProgressHook progress_;
+};
+
+} // namespace BulkTransfer
+
+#endif // BULK_TRANSFER_H
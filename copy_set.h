@@ -0,0 +1,74 @@
+#ifndef COPY_SET_H
+#define COPY_SET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+#include "small_vector.h"
+
+// 同一书目下各副本的在架状态：每册一位，置位表示在架可借。
+//
+// 两级位图：words_的每一位对应一册，summary_的第i位表示words_[i]中还有在架的副本。
+// 取编号最小的在架副本只需两次countr_zero，与副本数无关；最多支持64×64册。
+class CopySet {
+public:
+    static constexpr size_t MAX_COPIES = 64 * 64;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    
+    CopySet() = default;
+    
+    // 重置为count册，全部在架
+    void reset(size_t count) {
+        size_ = count;
+        free_ = count;
+        words_.assign((count + 63) / 64, ~uint64_t{0});
+        if (count % 64 != 0) {
+            words_.back() = (uint64_t{1} << (count % 64)) - 1;
+        }
+        summary_ = words_.empty() ? 0 : (words_.size() == 64 ? ~uint64_t{0} : (uint64_t{1} << words_.size()) - 1);
+    }
+    
+    size_t size() const { return size_; }
+    size_t freeCount() const { return free_; }
+    bool any() const { return summary_ != 0; }
+    
+    bool isFree(size_t copy) const {
+        return (words_[copy / 64] >> (copy % 64)) & 1;
+    }
+    
+    // 借出编号最小的在架副本，O(1)；没有在架副本时返回npos
+    size_t acquire() {
+        if (summary_ == 0) {
+            return npos;
+        }
+        size_t word = static_cast<size_t>(std::countr_zero(summary_));
+        size_t copy = word * 64 + static_cast<size_t>(std::countr_zero(words_[word]));
+        take(copy);
+        return copy;
+    }
+    
+    // 把指定副本标记为借出（用于从持久化数据重建）
+    void take(size_t copy) {
+        size_t word = copy / 64;
+        words_[word] &= ~(uint64_t{1} << (copy % 64));
+        if (words_[word] == 0) {
+            summary_ &= ~(uint64_t{1} << word);
+        }
+        --free_;
+    }
+    
+    void release(size_t copy) {
+        size_t word = copy / 64;
+        words_[word] |= uint64_t{1} << (copy % 64);
+        summary_ |= uint64_t{1} << word;
+        ++free_;
+    }
+
+private:
+    SmallVector<uint64_t, 1> words_; // 64册以内只有一个字，不做堆分配
+    uint64_t summary_ = 0;
+    size_t size_ = 0;
+    size_t free_ = 0;
+};
+
+#endif // COPY_SET_H
@@ -0,0 +1,219 @@
+#ifndef CSV_CODEC_H
+#define CSV_CODEC_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "json_codec.h"
+
+// 类型化CSV读写（RFC 4180）：与 json_codec.h 共用实体的 jsonFields() 字段表。
+//
+// 首行是表头，列名与JSON键名一致；读取时按列名匹配，未知列被忽略，缺失列保持原值。
+// 布尔写作 true/false，整数列表（如borrowHistory）写在一个单元格里，用分号分隔。
+// 含逗号、引号或换行的单元格加双引号，引号本身写两次。
+namespace Csv {
+
+namespace detail {
+
+inline void appendCell(std::string& out, std::string_view text) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+template <typename T>
+void appendInteger(std::string& out, T value) {
+    char buffer[24];
+    auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, end);
+}
+
+template <typename T>
+void writeField(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out += value ? "true" : "false";
+    } else if constexpr (std::is_integral_v<T>) {
+        appendInteger(out, value);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        appendCell(out, value);
+    } else if constexpr (std::is_same_v<T, Symbol>) {
+        appendCell(out, value.str());
+    } else {
+        bool first = true;
+        for (const auto& item : value) {
+            if (!first) out += ';';
+            first = false;
+            appendInteger(out, item);
+        }
+    }
+}
+
+template <typename T>
+T parseInteger(std::string_view token) {
+    T value = 0;
+    auto [end, ec] = std::from_chars(token.data(), token.data() + token.length(), value);
+    if (ec != std::errc() || end != token.data() + token.length()) {
+        throw std::invalid_argument("无效的整数: " + std::string(token));
+    }
+    return value;
+}
+
+// 与JSON读取不同，这里不做宽松转换：批量迁移时把坏数据悄悄读成0比报错更糟
+template <typename T>
+void readField(std::string_view cell, T& out) {
+    if constexpr (std::is_same_v<T, bool>) {
+        if (cell == "true" || cell == "1") {
+            out = true;
+        } else if (cell == "false" || cell == "0" || cell.empty()) {
+            out = false;
+        } else {
+            throw std::invalid_argument("无效的布尔值: " + std::string(cell));
+        }
+    } else if constexpr (std::is_integral_v<T>) {
+        if (!cell.empty()) {
+            out = parseInteger<T>(cell);
+        }
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        out.assign(cell);
+    } else if constexpr (std::is_same_v<T, Symbol>) {
+        out = Symbol(cell);
+    } else {
+        out.clear();
+        while (!cell.empty()) {
+            size_t end = std::min(cell.find(';'), cell.length());
+            out.push_back(parseInteger<typename T::value_type>(cell.substr(0, end)));
+            cell.remove_prefix(std::min(end + 1, cell.length()));
+        }
+    }
+}
+
+} // namespace detail
+
+template <typename T>
+void writeHeader(std::string& out) {
+    bool first = true;
+    auto writeName = [&](const auto& field) {
+        if (!first) out += ',';
+        first = false;
+        out += field.name;
+    };
+    std::apply([&](const auto&... fields) { (writeName(fields), ...); }, T::jsonFields());
+    out += '\n';
+}
+
+template <typename T>
+void writeRow(std::string& out, const T& obj) {
+    bool first = true;
+    auto writeMember = [&](const auto& field) {
+        if (!first) out += ',';
+        first = false;
+        detail::writeField(out, obj.*(field.member));
+    };
+    std::apply([&](const auto&... fields) { (writeMember(fields), ...); }, T::jsonFields());
+    out += '\n';
+}
+
+// 从pos开始的一条记录的结束位置（换行符之后）；引号内的换行属于单元格内容。
+// 文本中没有完整的记录时返回npos
+inline size_t findRecordEnd(std::string_view text, size_t pos) {
+    bool quoted = false;
+    while (pos < text.length()) {
+        const char* newline = static_cast<const char*>(std::memchr(text.data() + pos, '\n', text.length() - pos));
+        if (!newline) {
+            return std::string_view::npos;
+        }
+        size_t end = static_cast<size_t>(newline - text.data());
+        // 引号成对出现，奇数个引号表示换行落在引号内
+        if (std::count(text.data() + pos, newline, '"') % 2 != 0) {
+            quoted = !quoted;
+        }
+        pos = end + 1;
+        if (!quoted) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// 把一条记录（可带行尾换行）切分成单元格
+inline void splitRecord(std::string_view record, std::vector<std::string>& cells) {
+    while (!record.empty() && (record.back() == '\n' || record.back() == '\r')) {
+        record.remove_suffix(1);
+    }
+    cells.clear();
+    size_t pos = 0;
+    while (true) {
+        std::string& cell = cells.emplace_back();
+        if (pos < record.length() && record[pos] == '"') {
+            ++pos;
+            while (true) {
+                size_t quote = record.find('"', pos);
+                if (quote == std::string_view::npos) {
+                    throw std::invalid_argument("引号未闭合");
+                }
+                cell.append(record.substr(pos, quote - pos));
+                pos = quote + 1;
+                if (pos < record.length() && record[pos] == '"') {
+                    cell += '"';
+                    ++pos;
+                } else {
+                    break;
+                }
+            }
+            if (pos < record.length() && record[pos] != ',') {
+                throw std::invalid_argument("引号后应为逗号");
+            }
+        } else {
+            size_t end = std::min(record.find(',', pos), record.length());
+            cell.assign(record.substr(pos, end - pos));
+            pos = end;
+        }
+        if (pos >= record.length()) {
+            return;
+        }
+        ++pos; // 跳过逗号
+    }
+}
+
+// 表头绑定：结果与 T::jsonFields() 一一对应，值为该字段所在的列号，文件中没有该列时为-1
+template <typename T>
+std::vector<int> bindHeader(const std::vector<std::string>& header) {
+    std::vector<int> binding;
+    auto bindField = [&](const auto& field) {
+        auto it = std::find(header.begin(), header.end(), field.name);
+        binding.push_back(it == header.end() ? -1 : static_cast<int>(it - header.begin()));
+    };
+    std::apply([&](const auto&... fields) { (bindField(fields), ...); }, T::jsonFields());
+    return binding;
+}
+
+// 按表头绑定填充obj，最后调用 Json::finishRead；单元格格式错误时抛出 std::invalid_argument
+template <typename T>
+void readRow(const std::vector<std::string>& cells, const std::vector<int>& binding, T& obj) {
+    size_t index = 0;
+    auto readMember = [&](const auto& field) {
+        int column = binding[index++];
+        if (column >= 0 && static_cast<size_t>(column) < cells.size()) {
+            detail::readField(cells[column], obj.*(field.member));
+        }
+    };
+    std::apply([&](const auto&... fields) { (readMember(fields), ...); }, T::jsonFields());
+    Json::finishRead(obj);
+}
+
+} // namespace Csv
+
+#endif // CSV_CODEC_H
@@ -0,0 +1,95 @@
+#include "due_scheduler.h"
+
+DueScheduler::DueScheduler(std::time_t noticePeriod) : noticePeriod_(noticePeriod) {}
+
+std::time_t DueScheduler::eventTime(const Loan& loan, Stage stage) const {
+    return stage == Stage::Scheduled ? loan.dueTime - noticePeriod_ : loan.dueTime;
+}
+
+void DueScheduler::schedule(const Loan& loan) {
+    cancel(loan.recordId);
+    loans_[loan.recordId] = Entry{loan, Stage::Scheduled};
+    events_.push(Event{eventTime(loan, Stage::Scheduled), loan.recordId, Stage::Scheduled});
+}
+
+void DueScheduler::cancel(int recordId) {
+    auto it = loans_.find(recordId);
+    if (it == loans_.end()) {
+        return;
+    }
+    std::pair<std::time_t, int> key(it->second.loan.dueTime, recordId);
+    dueSoon_.erase(key);
+    overdue_.erase(key);
+    loans_.erase(it);
+    compact();
+}
+
+void DueScheduler::clear() {
+    events_ = {};
+    loans_.clear();
+    dueSoon_.clear();
+    overdue_.clear();
+}
+
+void DueScheduler::advance(std::time_t now) {
+    while (!events_.empty() && events_.top().at <= now) {
+        Event event = events_.top();
+        events_.pop();
+        
+        // 已归还或已重新排期的借阅留下的旧事件
+        auto it = loans_.find(event.recordId);
+        if (it == loans_.end() || it->second.stage != event.stage ||
+            eventTime(it->second.loan, event.stage) != event.at) {
+            continue;
+        }
+        
+        Entry& entry = it->second;
+        std::pair<std::time_t, int> key(entry.loan.dueTime, event.recordId);
+        if (event.stage == Stage::Scheduled) {
+            entry.stage = Stage::DueSoon;
+            dueSoon_.insert(key);
+            events_.push(Event{entry.loan.dueTime, event.recordId, Stage::DueSoon});
+            // 启动时已经逾期的借阅直接进入逾期集合，不再提醒；每笔借阅只提醒一次
+            if (entry.loan.dueTime > now && !entry.loan.reminded && dueSoonHook_) {
+                entry.loan.reminded = true;
+                dueSoonHook_(entry.loan);
+            }
+        } else {
+            entry.stage = Stage::Overdue;
+            dueSoon_.erase(key);
+            overdue_.insert(key);
+        }
+    }
+}
+
+std::vector<DueScheduler::Loan> DueScheduler::collect(const std::set<std::pair<std::time_t, int>>& index) const {
+    std::vector<Loan> result;
+    result.reserve(index.size());
+    for (const auto& key : index) {
+        result.push_back(loans_.at(key.second).loan);
+    }
+    return result;
+}
+
+std::vector<DueScheduler::Loan> DueScheduler::overdue() const {
+    return collect(overdue_);
+}
+
+std::vector<DueScheduler::Loan> DueScheduler::dueSoon() const {
+    return collect(dueSoon_);
+}
+
+void DueScheduler::compact() {
+    // 过期事件超过有效借阅数时重建堆，防止频繁借还让堆无限增长
+    if (events_.size() <= 2 * loans_.size() + 64) {
+        return;
+    }
+    std::vector<Event> live;
+    live.reserve(loans_.size());
+    for (const auto& [recordId, entry] : loans_) {
+        if (entry.stage != Stage::Overdue) {
+            live.push_back(Event{eventTime(entry.loan, entry.stage), recordId, entry.stage});
+        }
+    }
+    events_ = std::priority_queue<Event, std::vector<Event>, Later>(Later(), std::move(live));
+}
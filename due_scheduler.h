@@ -0,0 +1,78 @@
+#ifndef DUE_SCHEDULER_H
+#define DUE_SCHEDULER_H
+
+#include <vector>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <functional>
+#include <ctime>
+
+// 借阅到期调度：按应还时间维护未归还借阅的最小堆，随时知道哪些已逾期，而无需扫描借阅记录。
+//
+// 每笔借阅经历 已排期 -> 即将到期（应还前noticePeriod秒，触发提醒钩子）-> 已逾期 三个阶段，
+// 每个阶段切换对应堆里的一个事件。advance(now)只弹出到点的事件，代价是 O(到期数 × log n)。
+// 归还时只从索引中删除，堆里残留的事件在弹出时识别为过期并丢弃（惰性删除）。
+class DueScheduler {
+public:
+    struct Loan {
+        int recordId;
+        int userId;
+        int bookId;
+        std::time_t dueTime;
+        bool reminded = false; // 已提醒过（如重启前），进入提醒窗口时不再触发钩子
+    };
+    
+    using Hook = std::function<void(const Loan&)>;
+    
+    explicit DueScheduler(std::time_t noticePeriod);
+    
+    // 登记一笔未归还的借阅；recordId已存在时按新的应还时间重新排期
+    void schedule(const Loan& loan);
+    // 借阅已归还
+    void cancel(int recordId);
+    void clear();
+    
+    // 把时钟推进到now：进入提醒窗口的借阅触发一次提醒钩子，过了应还时间的移入逾期集合
+    void advance(std::time_t now);
+    
+    // 提醒钩子在advance中同步调用，不应再调用本对象
+    void setDueSoonHook(Hook hook) { dueSoonHook_ = std::move(hook); }
+    
+    // 按应还时间升序
+    std::vector<Loan> overdue() const;
+    std::vector<Loan> dueSoon() const;
+    size_t pendingCount() const { return loans_.size(); }
+    std::time_t noticePeriod() const { return noticePeriod_; }
+
+private:
+    enum class Stage { Scheduled, DueSoon, Overdue };
+    
+    struct Entry {
+        Loan loan;
+        Stage stage;
+    };
+    
+    struct Event {
+        std::time_t at;
+        int recordId;
+        Stage stage;  // 事件发生前借阅应处的阶段
+    };
+    
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const { return a.at > b.at; }
+    };
+    
+    std::time_t eventTime(const Loan& loan, Stage stage) const;
+    std::vector<Loan> collect(const std::set<std::pair<std::time_t, int>>& index) const;
+    void compact();
+    
+    std::time_t noticePeriod_;
+    std::priority_queue<Event, std::vector<Event>, Later> events_;
+    std::unordered_map<int, Entry> loans_;                 // 记录ID -> 未归还借阅
+    std::set<std::pair<std::time_t, int>> dueSoon_;        // (应还时间, 记录ID)
+    std::set<std::pair<std::time_t, int>> overdue_;        // (应还时间, 记录ID)
+    Hook dueSoonHook_;
+};
+
+#endif // DUE_SCHEDULER_H
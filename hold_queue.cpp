@@ -0,0 +1,157 @@
+#include "hold_queue.h"
+#include <algorithm>
+
+HoldQueues::HoldQueues(std::time_t pickupWindow) : pickupWindow_(pickupWindow) {}
+
+int HoldQueues::place(int bookId, int userId, std::time_t now) {
+    if (!members_.insert(memberKey(bookId, userId)).second) {
+        return 0;
+    }
+    std::deque<Hold>& queue = queues_[bookId];
+    queue.push_back(Hold{bookId, userId, now, 0});
+    return static_cast<int>(queue.size());
+}
+
+bool HoldQueues::cancel(int bookId, int userId) {
+    if (members_.erase(memberKey(bookId, userId)) == 0) {
+        return false;
+    }
+    auto it = queues_.find(bookId);
+    std::deque<Hold>& queue = it->second;
+    queue.erase(std::find_if(queue.begin(), queue.end(), [userId](const Hold& hold) { return hold.userId == userId; }));
+    if (queue.empty()) {
+        queues_.erase(it);
+    }
+    return true;
+}
+
+void HoldQueues::makeReady(Hold& hold, std::time_t now) {
+    hold.expiresAt = now + pickupWindow_;
+    expiries_.push(Expiry{hold.expiresAt, hold.bookId, hold.userId});
+    if (readyHook_) {
+        readyHook_(hold);
+    }
+}
+
+const HoldQueues::Hold* HoldQueues::find(int bookId, int userId) const {
+    if (!members_.count(memberKey(bookId, userId))) {
+        return nullptr;
+    }
+    const std::deque<Hold>& queue = queues_.at(bookId);
+    return &*std::find_if(queue.begin(), queue.end(), [userId](const Hold& hold) { return hold.userId == userId; });
+}
+
+const HoldQueues::Hold* HoldQueues::offer(int bookId, std::time_t now) {
+    auto it = queues_.find(bookId);
+    if (it == queues_.end()) {
+        return nullptr;
+    }
+    // 跳过待取书的前缀，长度不超过副本数
+    auto waiting = std::find_if(it->second.begin(), it->second.end(), [](const Hold& hold) { return !hold.isReady(); });
+    if (waiting == it->second.end()) {
+        return nullptr;
+    }
+    makeReady(*waiting, now);
+    return &*waiting;
+}
+
+size_t HoldQueues::readyCount(int bookId) const {
+    auto it = queues_.find(bookId);
+    if (it == queues_.end()) {
+        return 0;
+    }
+    auto waiting = std::find_if(it->second.begin(), it->second.end(), [](const Hold& hold) { return !hold.isReady(); });
+    return static_cast<size_t>(waiting - it->second.begin());
+}
+
+bool HoldQueues::isReadyFor(int bookId, int userId) const {
+    const Hold* hold = find(bookId, userId);
+    return hold && hold->isReady();
+}
+
+bool HoldQueues::fulfill(int bookId, int userId) {
+    return isReadyFor(bookId, userId) && cancel(bookId, userId);
+}
+
+std::vector<int> HoldQueues::expire(std::time_t now) {
+    std::vector<int> released;
+    while (!expiries_.empty() && expiries_.top().at <= now) {
+        Expiry expiry = expiries_.top();
+        expiries_.pop();
+        
+        // 预约已取消或已借走（之后又重新预约）时，这是一个过期事件
+        const Hold* hold = find(expiry.bookId, expiry.userId);
+        if (!hold || hold->expiresAt != expiry.at) {
+            continue;
+        }
+        cancel(expiry.bookId, expiry.userId);
+        offer(expiry.bookId, now);
+        released.push_back(expiry.bookId);
+    }
+    return released;
+}
+
+void HoldQueues::dropBook(int bookId) {
+    auto it = queues_.find(bookId);
+    if (it == queues_.end()) {
+        return;
+    }
+    for (const Hold& hold : it->second) {
+        members_.erase(memberKey(bookId, hold.userId));
+    }
+    queues_.erase(it);
+}
+
+std::vector<HoldQueues::Hold> HoldQueues::forBook(int bookId) const {
+    auto it = queues_.find(bookId);
+    if (it == queues_.end()) {
+        return {};
+    }
+    return std::vector<Hold>(it->second.begin(), it->second.end());
+}
+
+std::vector<HoldQueues::Hold> HoldQueues::forUser(int userId) const {
+    std::vector<Hold> result;
+    for (const auto& entry : queues_) {
+        for (const Hold& hold : entry.second) {
+            if (hold.userId == userId) {
+                result.push_back(hold);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const Hold& a, const Hold& b) { return a.placedTime < b.placedTime; });
+    return result;
+}
+
+std::vector<HoldQueues::Hold> HoldQueues::all() const {
+    std::vector<Hold> result;
+    result.reserve(members_.size());
+    for (const auto& entry : queues_) {
+        result.insert(result.end(), entry.second.begin(), entry.second.end());
+    }
+    return result;
+}
+
+void HoldQueues::restore(const std::vector<Hold>& holds) {
+    clear();
+    for (const Hold& hold : holds) {
+        if (!members_.insert(memberKey(hold.bookId, hold.userId)).second) {
+            continue;
+        }
+        std::deque<Hold>& queue = queues_[hold.bookId];
+        queue.push_back(hold);
+        // 待取书的预约只能是队列前缀
+        if (queue.size() > 1 && !queue[queue.size() - 2].isReady()) {
+            queue.back().expiresAt = 0;
+        } else if (hold.isReady()) {
+            expiries_.push(Expiry{hold.expiresAt, hold.bookId, hold.userId});
+        }
+    }
+}
+
+void HoldQueues::clear() {
+    queues_.clear();
+    members_.clear();
+    expiries_ = {};
+}
@@ -0,0 +1,95 @@
+#ifndef HOLD_QUEUE_H
+#define HOLD_QUEUE_H
+
+#include <vector>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <tuple>
+#include <functional>
+#include <ctime>
+#include "json_codec.h"
+
+// 图书预约：每本书一个先来先服务的预约队列。
+//
+// 每空出一册，排在最前的等待者转为"待取书"状态并开始计时，这一册只能由该读者在取书期限内借走，
+// 期限过了就轮到下一位。待取书的预约总是队列的前缀。待取书的期限用最小堆管理，expire(now)只处理到期的预约，
+// 代价是 O(到期数 × log n)；被取消或已借走的预约在弹出时识别为过期事件并丢弃。
+class HoldQueues {
+public:
+    struct Hold {
+        int bookId = 0;
+        int userId = 0;
+        std::time_t placedTime = 0;
+        std::time_t expiresAt = 0; // 0表示仍在排队；非0表示书已留出，需在此之前借走
+        
+        bool isReady() const { return expiresAt != 0; }
+        
+        static constexpr auto jsonFields() {
+            return std::make_tuple(
+                Json::field("bookId", &Hold::bookId),
+                Json::field("userId", &Hold::userId),
+                Json::field("placedTime", &Hold::placedTime),
+                Json::field("expiresAt", &Hold::expiresAt));
+        }
+    };
+    
+    explicit HoldQueues(std::time_t pickupWindow);
+    
+    // 排到队尾，O(1)；同一读者对同一本书只能预约一次。返回排队位置（从1开始），失败返回0
+    int place(int bookId, int userId, std::time_t now);
+    bool cancel(int bookId, int userId);
+    
+    // 空出一册时调用：最前面的等待者转为待取书，返回它；没有人在等时返回nullptr
+    const Hold* offer(int bookId, std::time_t now);
+    // 这本书有几册正留给待取书的读者
+    size_t readyCount(int bookId) const;
+    bool isReadyFor(int bookId, int userId) const;
+    // 读者借走了留给自己的书，移除其预约
+    bool fulfill(int bookId, int userId);
+    
+    // 处理过期的待取书预约并顺延给下一位；返回有预约过期的图书ID（可能重复）
+    std::vector<int> expire(std::time_t now);
+    // 图书被删除时丢弃它的整个队列
+    void dropBook(int bookId);
+    
+    // 预约转为待取书时同步调用（可用于通知读者），不应再调用本对象
+    void setReadyHook(std::function<void(const Hold&)> hook) { readyHook_ = std::move(hook); }
+    
+    // 按排队顺序
+    std::vector<Hold> forBook(int bookId) const;
+    std::vector<Hold> forUser(int userId) const;
+    std::vector<Hold> all() const;
+    size_t size() const { return members_.size(); }
+    
+    // 从持久化数据恢复（按文件中的顺序排队），已过期的待取书预约会在下一次expire时处理
+    void restore(const std::vector<Hold>& holds);
+    void clear();
+
+private:
+    struct Expiry {
+        std::time_t at;
+        int bookId;
+        int userId;
+    };
+    
+    struct Later {
+        bool operator()(const Expiry& a, const Expiry& b) const { return a.at > b.at; }
+    };
+    
+    static uint64_t memberKey(int bookId, int userId) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(bookId)) << 32) | static_cast<uint32_t>(userId);
+    }
+    
+    void makeReady(Hold& hold, std::time_t now);
+    const Hold* find(int bookId, int userId) const;
+    
+    std::time_t pickupWindow_;
+    std::unordered_map<int, std::deque<Hold>> queues_; // 图书ID -> 预约队列
+    std::unordered_set<uint64_t> members_;             // (图书ID, 用户ID)，用于O(1)判重
+    std::priority_queue<Expiry, std::vector<Expiry>, Later> expiries_;
+    std::function<void(const Hold&)> readyHook_;
+};
+
+#endif // HOLD_QUEUE_H
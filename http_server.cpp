@@ -1,4 +1,5 @@
 #include "http_server.h"
+#include "local_time.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -48,6 +49,14 @@ void HttpServer::setupRoutes() {
     routes["/api/borrow"] = [this](const HttpRequest& req) { return handleApiBorrow(req); };
     routes["/api/return"] = [this](const HttpRequest& req) { return handleApiReturn(req); };
     routes["/api/statistics"] = [this](const HttpRequest& req) { return handleApiStatistics(req); };
+    routes["/api/statistics/timeseries"] = [this](const HttpRequest& req) { return handleApiTimeSeries(req); };
+    routes["/api/statistics/trending"] = [this](const HttpRequest& req) { return handleApiTrending(req); };
+    routes["/api/statistics/heatmap"] = [this](const HttpRequest& req) { return handleApiHeatmap(req); };
+    routes["/api/overdue"] = [this](const HttpRequest& req) { return handleApiOverdue(req); };
+    routes["/api/holds"] = [this](const HttpRequest& req) { return handleApiHolds(req); };
+    routes["/api/books/batch"] = [this](const HttpRequest& req) { return handleApiBooksBatch(req); };
+    routes["/api/circulation"] = [this](const HttpRequest& req) { return handleApiCirculation(req); };
+    routes["/api/books/facets"] = [this](const HttpRequest& req) { return handleApiBookFacets(req); };
 }
 
 void HttpServer::start() {
@@ -76,6 +85,7 @@ void HttpServer::start() {
     }
     
     running = true;
+    maintenanceThread = std::thread(&HttpServer::runMaintenance, this);
     std::cout << "HTTP服务器启动成功，监听端口: " << port << std::endl;
     
     // 自动打开浏览器
@@ -97,13 +107,29 @@ void HttpServer::start() {
 }
 
 void HttpServer::stop() {
-    running = false;
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex);
+        running = false;
+    }
+    maintenanceWake.notify_all();
+    if (maintenanceThread.joinable()) {
+        maintenanceThread.join();
+    }
     if (serverSocket != INVALID_SOCKET) {
         closesocket(serverSocket);
         serverSocket = INVALID_SOCKET;
     }
 }
 
+void HttpServer::runMaintenance() {
+    std::unique_lock<std::mutex> lock(maintenanceMutex);
+    while (!maintenanceWake.wait_for(lock, MAINTENANCE_INTERVAL, [this] { return !running; })) {
+        lock.unlock();
+        librarySystem->pollDueDates();
+        lock.lock();
+    }
+}
+
 void HttpServer::handleClient(SOCKET clientSocket) {
     try {
         std::string requestData;
@@ -155,7 +181,7 @@ void HttpServer::handleClient(SOCKET clientSocket) {
         if (content_length > 0) {
             size_t body_start_pos = header_end_pos + 4;
             size_t body_received = requestData.length() - body_start_pos;
-            if (body_received < content_length) {
+            if (body_received < static_cast<size_t>(content_length)) {
                 requestData.resize(body_start_pos + content_length);
                 int remaining = content_length - body_received;
                 int current_pos = body_start_pos + body_received;
@@ -181,7 +207,17 @@ void HttpServer::handleClient(SOCKET clientSocket) {
             response = it->second(request);
         } else {
             // 检查是否是带参数的API路由
-            if (request.path.find("/api/users/") == 0 && request.path.length() > 11) {
+            auto endsWith = [&request](std::string_view suffix) {
+                return request.path.size() > suffix.size() &&
+                       request.path.compare(request.path.size() - suffix.size(), suffix.size(), suffix) == 0;
+            };
+            if (request.path.find("/api/users/") == 0 && endsWith("/records")) {
+                // 处理 /api/users/{id}/records 路由
+                response = handleApiUserRecords(request);
+            } else if (request.path.find("/api/users/") == 0 && endsWith("/stats")) {
+                // 处理 /api/users/{id}/stats 路由
+                response = handleApiUserStats(request);
+            } else if (request.path.find("/api/users/") == 0 && request.path.length() > 11) {
                 // 处理 /api/users/{id} 路由
                 response = handleApiUsers(request);
             } else if (request.path.find("/api/books/") == 0 && request.path.length() > 11) {
@@ -371,13 +407,13 @@ std::string HttpServer::urlDecode(const std::string& str) {
     return result;
 }
 
-HttpResponse HttpServer::handleIndex(const HttpRequest& request) {
+HttpResponse HttpServer::handleIndex(const HttpRequest&) {
     HttpResponse response;
     response.body = generateIndexPage();
     return response;
 }
 
-HttpResponse HttpServer::handleLogin(const HttpRequest& request) {
+HttpResponse HttpServer::handleLogin(const HttpRequest&) {
     HttpResponse response;
     response.body = generateLoginPage();
     return response;
@@ -415,7 +451,8 @@ HttpResponse HttpServer::handleApiLogin(const HttpRequest& request) {
         // 根据用户名判断用户类型并验证
         bool loginSuccess = false;
         std::string message = "";
-        std::string userType = ""        std::string actualUsername = "";
+        std::string userType = "";
+        std::string actualUsername = "";
         int userId = -1;
         
         // 管理员账户验证
@@ -431,10 +468,12 @@ HttpResponse HttpServer::handleApiLogin(const HttpRequest& request) {
             try {
                 std::ifstream file("data/users.json");
                 if (file.is_open()) {
-                    Json::Value usersData;
-                    file >> usersData;
+                    Json::Document usersDoc;
+                    usersDoc.parse(std::string((std::istreambuf_iterator<char>(file)),
+                                               std::istreambuf_iterator<char>()));
                     file.close();
                     
+                    const Json::Value& usersData = usersDoc.root();
                     if (usersData.isArray()) {
                         for (const auto& user : usersData) {
                             std::string userName = user["name"].asString();
@@ -477,7 +516,7 @@ HttpResponse HttpServer::handleApiLogin(const HttpRequest& request) {
     return errorResponse(405, "Method Not Allowed");
 }
 
-HttpResponse HttpServer::handleStaticFile(const HttpRequest& request, const std::string& filePath) {
+HttpResponse HttpServer::handleStaticFile(const HttpRequest&, const std::string& filePath) {
     HttpResponse response;
     std::string content = readFile(filePath);
     
@@ -495,12 +534,10 @@ HttpResponse HttpServer::handleStaticFile(const HttpRequest& request, const std:
 HttpResponse HttpServer::handleApiUsers(const HttpRequest& request) {
     if (request.method == "GET") {
         // 获取用户列表
-        Json::Value usersJson(Json::arrayValue);
-        auto users = librarySystem->getAllUsers();
-        for (User* user : users) {
-            usersJson.append(user->toJson());
-        }
-        return jsonResponse(usersJson);
+        // 直接序列化到响应体，跳过中间DOM
+        std::string body;
+        Json::writeArray(body, librarySystem->getAllUsers());
+        return jsonTextResponse(std::move(body));
     } else if (request.method == "POST") {
         // 添加用户
         std::string name, email, phone;
@@ -613,22 +650,23 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
     if (request.method == "GET") {
         // 获取图书列表
         auto search = request.queryParams.find("search");
-        std::vector<Book*> books;
+        std::string keyword = (search != request.queryParams.end()) ? search->second : "";
         
-        if (search != request.queryParams.end() && !search->second.empty()) {
-            books = librarySystem->searchBooks(search->second);
-        } else {
-            books = librarySystem->getAllBooks();
-        }
-        
-        Json::Value booksJson(Json::arrayValue);
-        for (Book* book : books) {
-            booksJson.append(book->toJson());
-        }
-        return jsonResponse(booksJson);
+        // 边遍历边序列化到响应体：既跳过中间DOM，也不会物化延迟目录中的图书
+        std::string body = "[";
+        librarySystem->forEachBook([&](const Book& book) {
+            if (!keyword.empty() && !book.matchesKeyword(keyword)) {
+                return;
+            }
+            if (body.size() > 1) body += ',';
+            Json::writeObject(body, book);
+        });
+        body += ']';
+        return jsonTextResponse(std::move(body));
     } else if (request.method == "POST") {
         // 添加图书
         std::string title, author, category, keywords, description;
+        std::string copies = "1";
         
         // 检查Content-Type来决定如何解析数据
         auto contentType = request.headers.find("Content-Type");
@@ -642,6 +680,7 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
                 category = jsonData["category"].isNull() ? "" : jsonData["category"].asString();
                 keywords = jsonData["keywords"].isNull() ? "" : jsonData["keywords"].asString();
                 description = jsonData["description"].isNull() ? "" : jsonData["description"].asString();
+                copies = jsonData["copies"].isNull() ? copies : jsonData["copies"].asString();
             } else {
                 return errorResponse(400, "缺少必要参数");
             }
@@ -652,6 +691,7 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
             auto categoryIt = request.postParams.find("category");
             auto keywordsIt = request.postParams.find("keywords");
             auto descriptionIt = request.postParams.find("description");
+            auto copiesIt = request.postParams.find("copies");
             
             if (titleIt != request.postParams.end() && authorIt != request.postParams.end()) {
                 title = titleIt->second;
@@ -659,12 +699,20 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
                 category = (categoryIt != request.postParams.end()) ? categoryIt->second : "";
                 keywords = (keywordsIt != request.postParams.end()) ? keywordsIt->second : "";
                 description = (descriptionIt != request.postParams.end()) ? descriptionIt->second : "";
+                copies = (copiesIt != request.postParams.end() && !copiesIt->second.empty()) ? copiesIt->second : copies;
             } else {
                 return errorResponse(400, "缺少必要参数");
             }
         }
         
-        int bookId = librarySystem->addBook(title, author, category, keywords, description);
+        int copyCount;
+        try {
+            copyCount = std::stoi(copies);
+        } catch (const std::exception& e) {
+            return errorResponse(400, "无效的副本数");
+        }
+        
+        int bookId = librarySystem->addBook(title, author, category, keywords, description, copyCount);
         if (bookId > 0) {
             Json::Value result;
             result["success"] = true;
@@ -691,6 +739,7 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
         }
         
         std::string title, author, category, keywords, description;
+        int copies = 0; // 不传时保持原副本数
         
         // 解析JSON数据
         Json::Value jsonData = parseJsonBody(request.body);
@@ -700,17 +749,22 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
             category = jsonData["category"].isNull() ? "" : jsonData["category"].asString();
             keywords = jsonData["keywords"].isNull() ? "" : jsonData["keywords"].asString();
             description = jsonData["description"].isNull() ? "" : jsonData["description"].asString();
+            try {
+                copies = jsonData["copies"].isNull() ? 0 : std::stoi(jsonData["copies"].asString());
+            } catch (const std::exception& e) {
+                return errorResponse(400, "无效的副本数");
+            }
         } else {
             return errorResponse(400, "缺少必要参数");
         }
         
-        if (librarySystem->updateBook(bookId, title, author, category, keywords, description)) {
+        if (librarySystem->updateBook(bookId, title, author, category, keywords, description, copies)) {
             Json::Value result;
             result["success"] = true;
             result["message"] = "图书修改成功";
             return jsonResponse(result);
         }
-        return errorResponse(400, "修改图书失败");
+        return errorResponse(400, "修改图书失败：图书不存在、输入无效或副本数少于已借出和已预留的册数");
     } else if (request.method == "DELETE") {
         // 删除图书
         // 从URL路径中提取图书ID
@@ -739,6 +793,146 @@ HttpResponse HttpServer::handleApiBooks(const HttpRequest& request) {
     return errorResponse(405, "Method Not Allowed");
 }
 
+// 批量添加图书：请求体是图书对象的JSON数组（字段同POST /api/books），整批只保存一次。
+// 每一项单独校验，响应中的results与请求一一对应，部分失败时其余项照常添加
+HttpResponse HttpServer::handleApiBooksBatch(const HttpRequest& request) {
+    if (request.method != "POST") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    // 直接从请求体解析到输入结构，不构造中间DOM
+    std::vector<LibrarySystem::BookInput> inputs;
+    bool parsed = Json::readArray(request.body, [&inputs](Json::Scanner& in) {
+        Json::readObject(in, inputs.emplace_back());
+    });
+    if (!parsed) {
+        return errorResponse(400, "无效的JSON数组");
+    }
+    if (inputs.empty()) {
+        return errorResponse(400, "批量数据为空");
+    }
+    
+    std::vector<LibrarySystem::ItemResult> results = librarySystem->addBooks(inputs);
+    
+    Json::Value json;
+    Json::Value& items = json.emplace("results", Json::arrayValue);
+    items.reserve(results.size());
+    int added = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        Json::Value& item = items.emplaceBack(Json::objectValue);
+        item.emplace("index", static_cast<int>(i));
+        item.emplace("success", results[i].ok());
+        if (results[i].ok()) {
+            item.emplace("bookId", results[i].id);
+            ++added;
+        } else {
+            item.emplace("message", results[i].error);
+        }
+    }
+    json["success"] = added == static_cast<int>(results.size());
+    json["added"] = added;
+    json["failed"] = static_cast<int>(results.size()) - added;
+    json["message"] = "已添加 " + std::to_string(added) + " 本，失败 " + std::to_string(results.size() - added) + " 本";
+    return jsonResponse(json, added > 0 ? 200 : 400);
+}
+
+// GET /api/books/facets?field=category|author&limit=N
+// 每个分类（默认）或作者下的图书数，按数量降序；不带limit时返回全部
+HttpResponse HttpServer::handleApiBookFacets(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    auto fieldParam = request.queryParams.find("field");
+    std::string field = (fieldParam != request.queryParams.end()) ? fieldParam->second : "category";
+    if (field != "category" && field != "author") {
+        return errorResponse(400, "field必须是category或author");
+    }
+    
+    size_t limit = SIZE_MAX;
+    auto limitParam = request.queryParams.find("limit");
+    if (limitParam != request.queryParams.end()) {
+        try {
+            int requested = std::stoi(limitParam->second);
+            if (requested <= 0) {
+                return errorResponse(400, "无效的limit参数");
+            }
+            limit = static_cast<size_t>(requested);
+        } catch (const std::exception& e) {
+            return errorResponse(400, "无效的limit参数");
+        }
+    }
+    
+    std::vector<LibrarySystem::FacetCount> facets = librarySystem->getBookFacets(field);
+    Json::Value json;
+    json["field"] = field;
+    json["total"] = static_cast<int>(facets.size());
+    Json::Value& items = json.emplace("facets", Json::arrayValue);
+    items.reserve(std::min(limit, facets.size()));
+    for (size_t i = 0; i < facets.size() && i < limit; ++i) {
+        Json::Value& item = items.emplaceBack(Json::objectValue);
+        item.emplace("value", facets[i].value);
+        item.emplace("count", facets[i].count);
+    }
+    return jsonResponse(json);
+}
+
+// 柜台批量借还：{"userId":1,"action":"borrow"|"return","bookIds":[...]}。
+// 整批要么全部执行要么都不执行，results与bookIds一一对应，失败时给出每项原因
+HttpResponse HttpServer::handleApiCirculation(const HttpRequest& request) {
+    if (request.method != "POST") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    Json::Value jsonData = parseJsonBody(request.body);
+    if (!jsonData.isObject() || jsonData["userId"].isNull() || !jsonData["bookIds"].isArray()) {
+        return errorResponse(400, "缺少必要参数");
+    }
+    std::string action = jsonData["action"].asString();
+    if (action != "borrow" && action != "return") {
+        return errorResponse(400, "action必须是borrow或return");
+    }
+    
+    int userId;
+    std::vector<int> bookIds;
+    try {
+        userId = std::stoi(jsonData["userId"].asString());
+        const Json::Value& ids = jsonData["bookIds"];
+        bookIds.reserve(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            bookIds.push_back(std::stoi(ids[static_cast<int>(i)].asString()));
+        }
+    } catch (const std::exception& e) {
+        return errorResponse(400, "无效的用户ID或图书ID");
+    }
+    if (bookIds.empty()) {
+        return errorResponse(400, "图书列表为空");
+    }
+    
+    std::vector<LibrarySystem::ItemResult> results = action == "borrow"
+        ? librarySystem->borrowBooks(userId, bookIds)
+        : librarySystem->returnBooks(userId, bookIds);
+    
+    Json::Value json;
+    Json::Value& items = json.emplace("results", Json::arrayValue);
+    items.reserve(results.size());
+    bool success = true;
+    for (size_t i = 0; i < results.size(); ++i) {
+        Json::Value& item = items.emplaceBack(Json::objectValue);
+        item.emplace("bookId", bookIds[i]);
+        item.emplace("success", results[i].ok());
+        if (!results[i].ok()) {
+            item.emplace("message", results[i].error);
+            success = false;
+        }
+    }
+    const char* verb = action == "borrow" ? "借阅" : "归还";
+    json["success"] = success;
+    json["message"] = success ? std::string(verb) + "成功，共 " + std::to_string(results.size()) + " 本"
+                              : std::string(verb) + "失败，整批未执行";
+    return jsonResponse(json, success ? 200 : 400);
+}
+
 HttpResponse HttpServer::handleApiBorrow(const HttpRequest& request) {
     if (request.method == "POST") {
         std::string userIdStr, bookIdStr;
@@ -780,7 +974,7 @@ HttpResponse HttpServer::handleApiBorrow(const HttpRequest& request) {
             } else {
                 Json::Value result;
                 result["success"] = false;
-                result["message"] = "借阅失败：用户不存在、图书不可借或已达借阅上限";
+                result["message"] = "借阅失败：用户不存在、图书不可借（已借出或已为预约者保留）或已达借阅上限";
                 return jsonResponse(result, 400);
             }
         } catch (const std::exception& e) {
@@ -843,20 +1037,249 @@ HttpResponse HttpServer::handleApiReturn(const HttpRequest& request) {
 
 HttpResponse HttpServer::handleApiStatistics(const HttpRequest& request) {
     if (request.method == "GET") {
-        Json::Value stats = librarySystem->getStatisticsJson();
-        
         // 添加额外的统计信息
         Json::Value result;
-        result["statistics"] = stats;
+        result["statistics"] = librarySystem->getStatisticsJson();
         result["totalUsers"] = static_cast<int>(librarySystem->getAllUsers().size());
-        result["totalBooks"] = static_cast<int>(librarySystem->getAllBooks().size());
-        result["totalRecords"] = static_cast<int>(librarySystem->getAllBorrowRecords().size());
+        result["totalBooks"] = static_cast<int>(librarySystem->getBookCount());
+        result["totalRecords"] = static_cast<int>(librarySystem->getBorrowRecordCount());
         
         return jsonResponse(result);
     }
     return errorResponse(405, "Method Not Allowed");
 }
 
+// GET /api/users/{id}/records
+// 读者的全部借阅记录（含已归档的月份，按月份顺序），每条附书名bookTitle
+HttpResponse HttpServer::handleApiUserRecords(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    int userId;
+    try {
+        userId = std::stoi(request.path.substr(11)); // "/api/users/"的长度是11，数字后面的路径被忽略
+    } catch (const std::exception& e) {
+        return errorResponse(400, "无效的用户ID");
+    }
+    Json::Value records = librarySystem->getUserRecordsJson(userId);
+    if (records.isNull()) {
+        return errorResponse(404, "用户不存在");
+    }
+    return jsonResponse(records);
+}
+
+// GET /api/users/{id}/stats
+// 读者的借阅计数：totalBorrows、currentBorrows、averageLoanDays、overdueCount，来自增量维护的统计
+HttpResponse HttpServer::handleApiUserStats(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    int userId;
+    try {
+        userId = std::stoi(request.path.substr(11));
+    } catch (const std::exception& e) {
+        return errorResponse(400, "无效的用户ID");
+    }
+    Json::Value stats = librarySystem->getUserLoanStatsJson(userId);
+    if (stats.isNull()) {
+        return errorResponse(404, "用户不存在");
+    }
+    return jsonResponse(stats);
+}
+
+// GET /api/statistics/timeseries?granularity=hour|day|week&buckets=N
+// 返回最近N个时间桶的借出/归还次数，按时间从早到晚排列
+HttpResponse HttpServer::handleApiTimeSeries(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    auto granularityParam = request.queryParams.find("granularity");
+    std::string granularity = (granularityParam != request.queryParams.end()) ? granularityParam->second : "day";
+    
+    // 默认：最近24小时 / 30天 / 12周；超过序列容量的部分在LibrarySystem里截掉
+    size_t buckets = granularity == "hour" ? 24 : (granularity == "day" ? 30 : 12);
+    auto bucketsParam = request.queryParams.find("buckets");
+    if (bucketsParam != request.queryParams.end()) {
+        try {
+            int requested = std::stoi(bucketsParam->second);
+            if (requested <= 0) {
+                return errorResponse(400, "无效的buckets参数");
+            }
+            buckets = static_cast<size_t>(requested);
+        } catch (const std::exception& e) {
+            return errorResponse(400, "无效的buckets参数");
+        }
+    }
+    
+    Json::Value series = librarySystem->getTimeSeriesJson(granularity, buckets);
+    if (series.isNull()) {
+        return errorResponse(400, "granularity必须是hour、day或week");
+    }
+    return jsonResponse(series);
+}
+
+// GET /api/statistics/trending?category=xxx&limit=N
+// 最近的热门图书：得分每过一个半衰期减半；不带category时返回全馆及每个分类的前N名
+HttpResponse HttpServer::handleApiTrending(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    auto categoryParam = request.queryParams.find("category");
+    std::string category = (categoryParam != request.queryParams.end()) ? categoryParam->second : "";
+    
+    size_t limit = Statistics::TOP_K;
+    auto limitParam = request.queryParams.find("limit");
+    if (limitParam != request.queryParams.end()) {
+        try {
+            int requested = std::stoi(limitParam->second);
+            if (requested <= 0) {
+                return errorResponse(400, "无效的limit参数");
+            }
+            limit = std::min(static_cast<size_t>(requested), Statistics::TRENDING_CAPACITY);
+        } catch (const std::exception& e) {
+            return errorResponse(400, "无效的limit参数");
+        }
+    }
+    
+    return jsonResponse(librarySystem->getTrendingJson(category, limit));
+}
+
+// GET /api/statistics/heatmap?year=YYYY
+// 预先按 日期×小时 聚合好的借阅次数，默认为本地时间的当年
+HttpResponse HttpServer::handleApiHeatmap(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    int year = LocalTime::civilFromDays(LocalTime::localDays(std::time(nullptr))).year;
+    auto yearParam = request.queryParams.find("year");
+    if (yearParam != request.queryParams.end()) {
+        try {
+            year = std::stoi(yearParam->second);
+        } catch (const std::exception& e) {
+            return errorResponse(400, "无效的year参数");
+        }
+    }
+    
+    return jsonResponse(librarySystem->getHeatmapJson(year));
+}
+
+// GET /api/overdue
+// 已逾期和即将到期的借阅（按应还时间升序），由到期调度器维护，不扫描借阅记录
+HttpResponse HttpServer::handleApiOverdue(const HttpRequest& request) {
+    if (request.method != "GET") {
+        return errorResponse(405, "Method Not Allowed");
+    }
+    
+    std::time_t now = std::time(nullptr);
+    auto toJson = [now](Json::Value& list, const std::vector<DueScheduler::Loan>& loans) {
+        list.reserve(loans.size());
+        for (const auto& loan : loans) {
+            Json::Value& item = list.emplaceBack(Json::objectValue);
+            item.emplace("recordId", loan.recordId);
+            item.emplace("userId", loan.userId);
+            item.emplace("bookId", loan.bookId);
+            item.emplace("dueTime", static_cast<int64_t>(loan.dueTime));
+            // 逾期天数（不足一天按一天计）；即将到期的借阅为0
+            int64_t late = static_cast<int64_t>(now - loan.dueTime);
+            item.emplace("overdueDays", late > 0 ? (late + 86399) / 86400 : int64_t(0));
+        }
+    };
+    
+    Json::Value json;
+    toJson(json.emplace("overdue", Json::arrayValue), librarySystem->getOverdueLoans());
+    toJson(json.emplace("dueSoon", Json::arrayValue), librarySystem->getDueSoonLoans());
+    json.emplace("noticeSeconds", static_cast<int64_t>(LibrarySystem::DUE_NOTICE_PERIOD));
+    return jsonResponse(json);
+}
+
+// /api/holds 图书预约
+//   GET    ?bookId=N 或 ?userId=N   按排队顺序列出预约
+//   POST   {userId, bookId}          预约已借出的图书，返回排队位置
+//   DELETE ?userId=N&bookId=N        取消预约
+HttpResponse HttpServer::handleApiHolds(const HttpRequest& request) {
+    // 参数可以来自查询字符串、JSON请求体或表单
+    auto param = [this, &request](const std::string& name) -> std::string {
+        auto query = request.queryParams.find(name);
+        if (query != request.queryParams.end()) {
+            return query->second;
+        }
+        auto contentType = request.headers.find("Content-Type");
+        if (contentType != request.headers.end() &&
+            contentType->second.find("application/json") != std::string::npos) {
+            Json::Value jsonData = parseJsonBody(request.body);
+            if (jsonData.isObject() && !jsonData[name].isNull()) {
+                return jsonData[name].asString();
+            }
+            return "";
+        }
+        auto form = request.postParams.find(name);
+        return form != request.postParams.end() ? form->second : "";
+    };
+    
+    try {
+        std::string userIdStr = param("userId");
+        std::string bookIdStr = param("bookId");
+        
+        if (request.method == "GET") {
+            std::vector<HoldQueues::Hold> holds;
+            if (!bookIdStr.empty()) {
+                holds = librarySystem->getBookHolds(std::stoi(bookIdStr));
+            } else if (!userIdStr.empty()) {
+                holds = librarySystem->getUserHolds(std::stoi(userIdStr));
+            } else {
+                return errorResponse(400, "缺少bookId或userId参数");
+            }
+            
+            Json::Value json(Json::arrayValue);
+            json.reserve(holds.size());
+            for (const auto& hold : holds) {
+                Json::Value& item = json.emplaceBack(Json::objectValue);
+                item.emplace("bookId", hold.bookId);
+                item.emplace("userId", hold.userId);
+                item.emplace("placedTime", static_cast<int64_t>(hold.placedTime));
+                item.emplace("ready", hold.isReady());
+                item.emplace("expiresAt", static_cast<int64_t>(hold.expiresAt));
+            }
+            return jsonResponse(json);
+        }
+        
+        if (request.method != "POST" && request.method != "DELETE") {
+            return errorResponse(405, "Method Not Allowed");
+        }
+        if (userIdStr.empty() || bookIdStr.empty()) {
+            return errorResponse(400, "缺少必要参数");
+        }
+        int userId = std::stoi(userIdStr);
+        int bookId = std::stoi(bookIdStr);
+        
+        Json::Value result;
+        if (request.method == "POST") {
+            int position = librarySystem->placeHold(userId, bookId);
+            if (position == 0) {
+                result["success"] = false;
+                result["message"] = "预约失败：用户或图书不存在、图书可直接借阅或已预约过";
+                return jsonResponse(result, 400);
+            }
+            result["success"] = true;
+            result["message"] = "预约成功";
+            result["position"] = position;
+            return jsonResponse(result);
+        }
+        
+        if (!librarySystem->cancelHold(userId, bookId)) {
+            return errorResponse(404, "预约不存在");
+        }
+        result["success"] = true;
+        result["message"] = "已取消预约";
+        return jsonResponse(result);
+    } catch (const std::exception& e) {
+        return errorResponse(400, "无效的用户ID或图书ID");
+    }
+}
+
 std::string HttpServer::getContentType(const std::string& filename) {
     if (filename.size() >= 5 && filename.substr(filename.size() - 5) == ".html") return "text/html; charset=utf-8";
     if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".css") return "text/css";
@@ -900,13 +1323,15 @@ Json::Value HttpServer::parseJsonBody(const std::string& body) {
 }
 
 HttpResponse HttpServer::jsonResponse(const Json::Value& json, int statusCode) {
-    HttpResponse response(statusCode);
-    response.headers["Content-Type"] = "application/json; charset=utf-8";
-    
     Json::StreamWriterBuilder builder;
     builder["indentation"] = "";
-    response.body = Json::writeString(builder, json);
-    
+    return jsonTextResponse(Json::writeString(builder, json), statusCode);
+}
+
+HttpResponse HttpServer::jsonTextResponse(std::string body, int statusCode) {
+    HttpResponse response(statusCode);
+    response.headers["Content-Type"] = "application/json; charset=utf-8";
+    response.body = std::move(body);
     return response;
 }
 
@@ -2706,6 +3131,17 @@ std::string HttpServer::generateIndexPage() {
             }
         }
         
+        // 多册书目显示在架册数，如"可借阅 (3/5)"
+        function bookStatusText(book) {
+            const copies = book.copyBorrowers || [];
+            const text = book.isAvailable ? '可借阅' : '已借出';
+            if (copies.length <= 1) {
+                return text;
+            }
+            const free = copies.filter(userId => userId === 0).length;
+            return `${text} (${free}/${copies.length})`;
+        }
+        
         function displayBooks(books) {
             const tbody = document.querySelector('#booksTable tbody');
             tbody.innerHTML = '';
@@ -2713,7 +3149,7 @@ std::string HttpServer::generateIndexPage() {
             books.forEach(book => {
                 const row = tbody.insertRow();
                 const statusClass = book.isAvailable ? 'status-available' : 'status-borrowed';
-                const statusText = book.isAvailable ? '可借阅' : '已借出';
+                const statusText = bookStatusText(book);
                 
                 row.innerHTML = `
                     <td class="action-buttons">
@@ -2841,19 +3277,23 @@ std::string HttpServer::generateIndexPage() {
         function displayDetailedStatistics(stats) {
             const container = document.getElementById('statisticsContent');
             let html = '';
+            const readers = stats.distinctReaders || {};
+            const distinctBooks = stats.distinctBooks || {};
+            const errors = stats.distinctCountError || {};
+            const errorNote = (error) => error ? `（估计值，误差约±${(error * 100).toFixed(1)}%）` : '';
             
             // 最受欢迎的图书
             if (stats.bookPopularity) {
                 html += '<h3>📈 最受欢迎的图书</h3>';
                 html += '<table class="data-table">';
-                html += '<thead><tr><th>图书ID</th><th>借阅次数</th></tr></thead><tbody>';
+                html += `<thead><tr><th>图书ID</th><th>借阅次数</th><th>不同读者${errorNote(errors.book)}</th></tr></thead><tbody>`;
                 
                 const sortedBooks = Object.entries(stats.bookPopularity)
                     .sort(([,a], [,b]) => b - a)
                     .slice(0, 10);
                 
                 sortedBooks.forEach(([bookId, count]) => {
-                    html += `<tr><td>${bookId}</td><td>${count}</td></tr>`;
+                    html += `<tr><td>${bookId}</td><td>${count}</td><td>${readers[bookId] ?? '-'}</td></tr>`;
                 });
                 
                 html += '</tbody></table>';
@@ -2863,19 +3303,34 @@ std::string HttpServer::generateIndexPage() {
             if (stats.userActivity) {
                 html += '<h3>👥 最活跃的用户</h3>';
                 html += '<table class="data-table">';
-                html += '<thead><tr><th>用户ID</th><th>借阅次数</th></tr></thead><tbody>';
+                html += `<thead><tr><th>用户ID</th><th>借阅次数</th><th>不同图书${errorNote(errors.user)}</th></tr></thead><tbody>`;
                 
                 const sortedUsers = Object.entries(stats.userActivity)
                     .sort(([,a], [,b]) => b - a)
                     .slice(0, 10);
                 
                 sortedUsers.forEach(([userId, count]) => {
-                    html += `<tr><td>${userId}</td><td>${count}</td></tr>`;
+                    html += `<tr><td>${userId}</td><td>${count}</td><td>${distinctBooks[userId] ?? '-'}</td></tr>`;
                 });
                 
                 html += '</tbody></table>';
             }
             
+            // 各分类的不同读者
+            if (stats.categoryReaders && Object.keys(stats.categoryReaders).length > 0) {
+                html += `<h3>🏷️ 各分类的读者数${errorNote(errors.category)}</h3>`;
+                html += '<table class="data-table">';
+                html += '<thead><tr><th>分类</th><th>不同读者</th></tr></thead><tbody>';
+                
+                Object.entries(stats.categoryReaders)
+                    .sort(([,a], [,b]) => b - a)
+                    .forEach(([category, count]) => {
+                        html += `<tr><td>${category}</td><td>${count}</td></tr>`;
+                    });
+                
+                html += '</tbody></table>';
+            }
+            
             // 月度趋势
             if (stats.monthlyStats) {
                 html += '<h3>📊 月度借阅趋势</h3>';
@@ -3179,47 +3634,44 @@ std::string HttpServer::generateIndexPage() {
             }
         }
         
+        // 读者的全部借阅记录（含已归档的月份），每条附书名；records.json只含活动段，不能用来展示历史
+        async function fetchUserRecords(userId) {
+            const response = await fetch(`/api/users/${userId}/records`);
+            if (response.status === 404) {
+                return null;
+            }
+            if (!response.ok) {
+                throw new Error(`HTTP ${response.status}`);
+            }
+            return response.json();
+        }
+        
         // 加载当前借阅
         async function loadCurrentBorrowings(userId) {
             const container = document.getElementById('currentBorrowings');
             try {
-                // 获取用户信息
-                const usersResponse = await fetch('/data/users.json');
-                const users = await usersResponse.json();
-                const currentUser = users.find(user => user.id === userId);
-                
-                if (!currentUser) {
+                const records = await fetchUserRecords(userId);
+                if (!records) {
                     container.innerHTML = '<div style="text-align: center; color: var(--error-color); padding: 20px;">用户不存在</div>';
                     return;
                 }
                 
-                // 获取借阅记录
-                const recordsResponse = await fetch('/data/records.json');
-                const records = await recordsResponse.json();
-                
-                // 获取图书信息
-                const booksResponse = await fetch('/data/books.json');
-                const books = await booksResponse.json();
-                
-                // 筛选当前用户的未归还借阅记录
-                const currentBorrowings = records.filter(record => 
-                    record.userId === currentUser.id && !record.isReturned
-                );
+                // 筛选未归还的借阅记录
+                const currentBorrowings = records.filter(record => !record.isReturned);
                 
                 if (currentBorrowings.length === 0) {
                     container.innerHTML = '<div style="text-align: center; color: var(--secondary-color); padding: 20px;">暂无借阅记录</div>';
                 } else {
                     let html = '';
                     currentBorrowings.forEach(record => {
-                        const book = books.find(b => b.id === record.bookId);
                         const borrowDate = new Date(record.borrowTime * 1000);
-                        const dueDate = new Date(borrowDate.getTime() + 30 * 24 * 60 * 60 * 1000); // 假设借期30天
+                        const dueDate = new Date((record.dueTime || record.borrowTime + 30 * 24 * 60 * 60) * 1000); // 旧记录没有应还时间，按借期30天推算
                         const daysLeft = Math.ceil((dueDate - new Date()) / (1000 * 60 * 60 * 24));
                         const statusClass = daysLeft < 0 ? 'overdue' : daysLeft <= 3 ? 'due-soon' : 'normal';
                         
                         html += `
                             <div class="borrow-item ${statusClass}">
-                                <h4>${book ? book.title : '未知图书'}</h4>
+                                <h4>${record.bookTitle || '未知图书'}</h4>
                                 <p>借阅日期: ${borrowDate.toLocaleDateString()}</p>
                                 <p>应还日期: ${dueDate.toLocaleDateString()}</p>
                                 <p class="status">${daysLeft < 0 ? '已逾期' + Math.abs(daysLeft) + '天' : daysLeft <= 3 ? '即将到期' : '还有' + daysLeft + '天'}</p>
@@ -3238,41 +3690,28 @@ std::string HttpServer::generateIndexPage() {
         async function loadBorrowHistory(userId) {
             const container = document.getElementById('borrowHistory');
             try {
-                // 获取用户信息
-                const usersResponse = await fetch('/data/users.json');
-                const users = await usersResponse.json();
-                const currentUser = users.find(user => user.id === userId);
-                
-                if (!currentUser) {
+                const records = await fetchUserRecords(userId);
+                if (!records) {
                     container.innerHTML = '<div style="text-align: center; color: var(--error-color); padding: 20px;">用户不存在</div>';
                     return;
                 }
                 
-                // 获取借阅记录
-                const recordsResponse = await fetch('/data/records.json');
-                const records = await recordsResponse.json();
-                
-                // 获取图书信息
-                const booksResponse = await fetch('/data/books.json');
-                const books = await booksResponse.json();
-                
-                // 筛选当前用户的已归还借阅记录
-                const historyRecords = records.filter(record => 
-                    record.userId === currentUser.id && record.isReturned
-                );
+                // 筛选已归还的借阅记录，最近归还的在前
+                const historyRecords = records
+                    .filter(record => record.isReturned)
+                    .sort((a, b) => b.returnTime - a.returnTime);
                 
                 if (historyRecords.length === 0) {
                     container.innerHTML = '<div style="text-align: center; color: var(--secondary-color); padding: 20px;">暂无历史记录</div>';
                 } else {
                     let html = '';
                     historyRecords.slice(0, 5).forEach(record => {
-                        const book = books.find(b => b.id === record.bookId);
                         const borrowDate = new Date(record.borrowTime * 1000);
                         const returnDate = record.returnTime ? new Date(record.returnTime * 1000) : null;
                         
                         html += `
                             <div class="borrow-item">
-                                <h4>${book ? book.title : '未知图书'}</h4>
+                                <h4>${record.bookTitle || '未知图书'}</h4>
                                 <p>借阅日期: ${borrowDate.toLocaleDateString()}</p>
                                 <p>归还日期: ${returnDate ? returnDate.toLocaleDateString() : '未归还'}</p>
                             </div>
@@ -3289,79 +3728,36 @@ std::string HttpServer::generateIndexPage() {
             }
         }
         
-        // 加载借阅统计
+        // 加载借阅统计：计数由服务器的统计增量维护，包含已归档的月份
         async function loadBorrowStats(userId) {
             const container = document.getElementById('borrowStats');
             try {
-                // 获取用户信息
-                const usersResponse = await fetch('/data/users.json');
-                const users = await usersResponse.json();
-                const currentUser = users.find(user => user.id === userId);
-                
-                if (!currentUser) {
+                const response = await fetch(`/api/users/${userId}/stats`);
+                if (response.status === 404) {
                     container.innerHTML = '<div style="text-align: center; color: var(--error-color); padding: 20px;">用户不存在</div>';
                     return;
                 }
-                
-                // 获取借阅记录
-                const recordsResponse = await fetch('/data/records.json');
-                const records = await recordsResponse.json();
-                
-                // 筛选当前用户的借阅记录
-                const userRecords = records.filter(record => record.userId === currentUser.id);
-                
-                // 计算统计数据
-                const totalBorrows = userRecords.length;
-                const currentBorrows = userRecords.filter(record => !record.isReturned).length;
-                
-                // 计算平均借阅天数（仅计算已归还的记录）
-                const returnedRecords = userRecords.filter(record => record.isReturned && record.returnTime);
-                let avgBorrowDays = 0;
-                if (returnedRecords.length > 0) {
-                    const totalDays = returnedRecords.reduce((sum, record) => {
-                        const borrowTime = record.borrowTime * 1000;
-                        const returnTime = record.returnTime * 1000;
-                        const days = Math.ceil((returnTime - borrowTime) / (1000 * 60 * 60 * 24));
-                        return sum + days;
-                    }, 0);
-                    avgBorrowDays = Math.round(totalDays / returnedRecords.length);
+                if (!response.ok) {
+                    throw new Error(`HTTP ${response.status}`);
                 }
-                
-                // 计算逾期次数（假设借期30天）
-                let overdueCount = 0;
-                userRecords.forEach(record => {
-                    const borrowTime = record.borrowTime * 1000;
-                    const dueTime = borrowTime + 30 * 24 * 60 * 60 * 1000; // 30天后
-                    
-                    if (record.isReturned && record.returnTime) {
-                        // 已归还，检查是否逾期归还
-                        if (record.returnTime * 1000 > dueTime) {
-                            overdueCount++;
-                        }
-                    } else {
-                        // 未归还，检查是否已逾期
-                        if (Date.now() > dueTime) {
-                            overdueCount++;
-                        }
-                    }
-                });
+                const stats = await response.json();
                 
                 let html = `
                     <div class="stats-item">
                         <span class="stats-label">总借阅次数</span>
-                        <span class="stats-value">${totalBorrows}</span>
+                        <span class="stats-value">${stats.totalBorrows}</span>
                     </div>
                     <div class="stats-item">
                         <span class="stats-label">当前借阅</span>
-                        <span class="stats-value">${currentBorrows}</span>
+                        <span class="stats-value">${stats.currentBorrows}</span>
                     </div>
                     <div class="stats-item">
                         <span class="stats-label">平均借阅天数</span>
-                        <span class="stats-value">${avgBorrowDays} 天</span>
+                        <span class="stats-value">${stats.averageLoanDays} 天</span>
                     </div>
                     <div class="stats-item">
                         <span class="stats-label">逾期次数</span>
-                        <span class="stats-value">${overdueCount}</span>
+                        <span class="stats-value">${stats.overdueCount}</span>
                     </div>
                 `;
                 container.innerHTML = html;
@@ -3382,17 +3778,9 @@ std::string HttpServer::generateIndexPage() {
             }
             
             try {
-                // 获取图书信息
-                const booksResponse = await fetch('/data/books.json');
-                const books = await booksResponse.json();
-                
-                // 搜索图书
-                const filteredBooks = books.filter(book => 
-                    book.title.toLowerCase().includes(searchTerm.toLowerCase()) ||
-                    book.author.toLowerCase().includes(searchTerm.toLowerCase()) ||
-                    (book.category && book.category.toLowerCase().includes(searchTerm.toLowerCase())) ||
-                    (book.keywords && book.keywords.toLowerCase().includes(searchTerm.toLowerCase()))
-                );
+                // 由服务器按书名、作者、分类和关键词匹配，结果总是当前的目录
+                const booksResponse = await fetch(`/api/books?search=${encodeURIComponent(searchTerm)}`);
+                const filteredBooks = await booksResponse.json();
                 
                 if (filteredBooks.length === 0) {
                     container.innerHTML = '<div style="text-align: center; color: var(--secondary-color); padding: 20px;">未找到相关图书</div>';
@@ -3400,7 +3788,7 @@ std::string HttpServer::generateIndexPage() {
                     let html = '';
                     filteredBooks.forEach(book => {
                         const statusClass = book.isAvailable ? 'available' : 'borrowed';
-                        const statusText = book.isAvailable ? '可借阅' : '已借出';
+                        const statusText = bookStatusText(book);
                         
                         html += `
                             <div class="book-item ${statusClass}">
@@ -3420,21 +3808,24 @@ std::string HttpServer::generateIndexPage() {
             }
         }
         
-        // 加载热力图
+        // 加载热力图：服务器端已按 日期×小时 聚合，只下载当年有借阅的日期
         async function loadHeatmap() {
             const container = document.getElementById('heatmap');
             try {
-                const response = await fetch('/data/records.json');
+                const response = await fetch(`/api/statistics/heatmap?year=${new Date().getFullYear()}`);
                 if (response.ok) {
-                    const records = await response.json();
+                    const heatmap = await response.json();
                     
-                    // 处理借阅记录数据，生成热力图数据
-                    const heatmapData = processRecordsForHeatmap(records);
+                    // 日期 -> { total, hours }
+                    const heatmapData = {};
+                    heatmap.days.forEach(day => {
+                        heatmapData[day.date] = { total: day.total, hours: day.hours };
+                    });
                     
                     // 生成热力图
                     generateHeatmap(container, heatmapData);
                 } else {
-                    // 如果没有数据文件，生成示例热力图
+                    // 如果接口不可用，生成示例热力图
                     const sampleData = generateSampleHeatmapData();
                     generateHeatmap(container, sampleData);
                 }
@@ -3452,46 +3843,26 @@ std::string HttpServer::generateIndexPage() {
             const startDate = new Date(currentDate.getFullYear(), 0, 1);
             
             // 随机生成一些借阅数据
-            const books = ['JavaScript高级程序设计', '算法导论', '深入理解计算机系统', '设计模式', '数据结构与算法'];
-            
             for (let i = 0; i < 50; i++) {
                 const randomDate = new Date(startDate.getTime() + Math.random() * (currentDate.getTime() - startDate.getTime()));
-                const dateStr = randomDate.toISOString().split('T')[0];
+                const dateStr = formatLocalDate(randomDate);
                 
                 if (!data[dateStr]) {
-                    data[dateStr] = [];
+                    data[dateStr] = { total: 0, hours: new Array(24).fill(0) };
                 }
                 
-                const randomBook = books[Math.floor(Math.random() * books.length)];
-                data[dateStr].push(randomBook);
+                data[dateStr].total++;
+                data[dateStr].hours[randomDate.getHours()]++;
             }
             
             return data;
         }
         
-        // 处理借阅记录为热力图数据
-        function processRecordsForHeatmap(records) {
-            const heatmapData = {};
-            const currentDate = new Date();
-            
-            records.forEach(record => {
-                if (record.borrowDate && !record.returnDate) {
-                    // 只处理当前正在借阅的记录
-                    const borrowDate = new Date(record.borrowDate);
-                    const endDate = record.dueDate ? new Date(record.dueDate) : currentDate;
-                    
-                    // 为借阅期间的每一天添加图书记录
-                    for (let date = new Date(borrowDate); date <= endDate && date <= currentDate; date.setDate(date.getDate() + 1)) {
-                        const dateStr = date.toISOString().split('T')[0];
-                        if (!heatmapData[dateStr]) {
-                            heatmapData[dateStr] = [];
-                        }
-                        heatmapData[dateStr].push(record.bookTitle || '未知图书');
-                    }
-                }
-            });
-            
-            return heatmapData;
+        // 按本地时间格式化为 YYYY-MM-DD（与服务器端的日期一致）
+        function formatLocalDate(date) {
+            const month = String(date.getMonth() + 1).padStart(2, '0');
+            const day = String(date.getDate()).padStart(2, '0');
+            return `${date.getFullYear()}-${month}-${day}`;
         }
         
         // 生成热力图
@@ -3505,10 +3876,10 @@ std::string HttpServer::generateIndexPage() {
                         <span>少</span>
                         <div class="legend-colors" style="display: flex; gap: 2px;">
                             <div class="legend-item level-0" style="width: 10px; height: 10px; background-color: #ebedf0; border-radius: 2px;" title="无借阅"></div>
-                            <div class="legend-item level-1" style="width: 10px; height: 10px; background-color: #9be9a8; border-radius: 2px;" title="1本书"></div>
-                            <div class="legend-item level-2" style="width: 10px; height: 10px; background-color: #40c463; border-radius: 2px;" title="2本书"></div>
-                            <div class="legend-item level-3" style="width: 10px; height: 10px; background-color: #30a14e; border-radius: 2px;" title="3本书"></div>
-                            <div class="legend-item level-4" style="width: 10px; height: 10px; background-color: #216e39; border-radius: 2px;" title="4+本书"></div>
+                            <div class="legend-item level-1" style="width: 10px; height: 10px; background-color: #9be9a8; border-radius: 2px;" title="1次借阅"></div>
+                            <div class="legend-item level-2" style="width: 10px; height: 10px; background-color: #40c463; border-radius: 2px;" title="2次借阅"></div>
+                            <div class="legend-item level-3" style="width: 10px; height: 10px; background-color: #30a14e; border-radius: 2px;" title="3次借阅"></div>
+                            <div class="legend-item level-4" style="width: 10px; height: 10px; background-color: #216e39; border-radius: 2px;" title="4+次借阅"></div>
                         </div>
                         <span>多</span>
                     </div>
@@ -3537,17 +3908,19 @@ std::string HttpServer::generateIndexPage() {
                     const currentDate = new Date(weekStart);
                     currentDate.setDate(weekStart.getDate() + dayOffset);
                     
-                    const dateStr = currentDate.toISOString().split('T')[0];
+                    const dateStr = formatLocalDate(currentDate);
                     const isCurrentYear = currentDate.getFullYear() === currentYear;
                     
-                    const books = data[dateStr] || [];
-                    const level = Math.min(books.length, 4);
+                    const day = data[dateStr];
+                    const count = day ? day.total : 0;
+                    const level = Math.min(count, 4);
                     
                     let tooltip = `${dateStr}\n`;
-                    if (books.length === 0) {
+                    if (count === 0) {
                         tooltip += '无借阅记录';
                     } else {
-                        tooltip += `${books.length} 本书:\n${books.join('\n')}`;
+                        const peakHour = day.hours.indexOf(Math.max(...day.hours));
+                        tooltip += `${count} 次借阅\n最繁忙: ${peakHour}:00-${peakHour + 1}:00`;
                     }
                     
                     const levelColors = {
@@ -3785,6 +4158,10 @@ std::string HttpServer::generateIndexPage() {
                     <label for="modalBookDescription">简介</label>
                     <textarea id="modalBookDescription" name="description" rows="3">${book ? book.description || '' : ''}</textarea>
                 </div>
+                <div class="form-group">
+                    <label for="modalBookCopies">副本数</label>
+                    <input type="number" id="modalBookCopies" name="copies" min="1" max="4096" value="${book && book.copyBorrowers ? book.copyBorrowers.length : 1}">
+                </div>
             `;
             
             document.getElementById('modalFormContent').innerHTML = formContent;
@@ -6,6 +6,9 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -60,6 +63,12 @@ private:
     std::atomic<bool> running;
     LibrarySystem* librarySystem;
     
+    // 定时维护线程：没有请求进来时也按时推进到期排期、发出提醒
+    static constexpr std::chrono::seconds MAINTENANCE_INTERVAL{60};
+    std::thread maintenanceThread;
+    std::mutex maintenanceMutex;
+    std::condition_variable maintenanceWake;
+    
     // 路由处理函数类型
     using RouteHandler = std::function<HttpResponse(const HttpRequest&)>;
     std::map<std::string, RouteHandler> routes;
@@ -76,6 +85,7 @@ private:
     void cleanupWinsock();
     void setupRoutes();
     void handleClient(SOCKET clientSocket);
+    void runMaintenance();
     
     HttpRequest parseRequest(const std::string& requestData);
     std::string buildResponse(const HttpResponse& response);
@@ -91,16 +101,27 @@ private:
     HttpResponse handleStatic(const HttpRequest& request);
     HttpResponse handleStaticFile(const HttpRequest& request, const std::string& filePath);
     HttpResponse handleApiUsers(const HttpRequest& request);
+    HttpResponse handleApiUserRecords(const HttpRequest& request);
+    HttpResponse handleApiUserStats(const HttpRequest& request);
     HttpResponse handleApiBooks(const HttpRequest& request);
     HttpResponse handleApiBorrow(const HttpRequest& request);
     HttpResponse handleApiReturn(const HttpRequest& request);
     HttpResponse handleApiStatistics(const HttpRequest& request);
+    HttpResponse handleApiTimeSeries(const HttpRequest& request);
+    HttpResponse handleApiTrending(const HttpRequest& request);
+    HttpResponse handleApiHeatmap(const HttpRequest& request);
+    HttpResponse handleApiOverdue(const HttpRequest& request);
+    HttpResponse handleApiHolds(const HttpRequest& request);
+    HttpResponse handleApiBooksBatch(const HttpRequest& request);
+    HttpResponse handleApiCirculation(const HttpRequest& request);
+    HttpResponse handleApiBookFacets(const HttpRequest& request);
     
     // 工具函数
     std::string getContentType(const std::string& filename);
     std::string readFile(const std::string& filename);
     Json::Value parseJsonBody(const std::string& body);
     HttpResponse jsonResponse(const Json::Value& json, int statusCode = 200);
+    HttpResponse jsonTextResponse(std::string body, int statusCode = 200);
     HttpResponse errorResponse(int statusCode, const std::string& message);
     
     // HTML页面生成
@@ -8,6 +8,25 @@
 #include <iostream>
 #include <memory>
 #include <variant>
+#include <memory_resource>
+#include <string_view>
+#include <tuple>
+#include <charconv>
+#include <stdexcept>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JSON_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define JSON_TARGET_AVX2
+#else
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define JSON_SIMD_X86 0
+#endif
 
 namespace Json {
     
@@ -24,39 +43,293 @@ enum ValueType {
     objectValue
 };
 
+// 底层扫描与转义函数，DOM解析器(Reader)和类型化读写(json_codec.h)共用。
+// 在x86上按16/32字节一组查找空白结束位置以及引号/反斜杠，运行时根据CPU选择
+// AVX2、SSE2或逐字节实现；其他平台只使用逐字节实现。
+namespace detail {
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// 返回第一个非空白字符的下标，全是空白时返回n
+inline size_t findNonWhitespaceScalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && isWhitespace(p[i])) ++i;
+    return i;
+}
+
+// 返回第一个引号或反斜杠的下标，不存在时返回n
+inline size_t findStringSpecialScalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && p[i] != '"' && p[i] != '\\') ++i;
+    return i;
+}
+
+#if JSON_SIMD_X86
+
+inline size_t findNonWhitespaceSse2(const char* p, size_t n) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(ws)) & 0xFFFFu;
+        if (mask != 0) return i + std::countr_zero(mask);
+    }
+    return i + findNonWhitespaceScalar(p + i, n - i);
+}
+
+inline size_t findStringSpecialSse2(const char* p, size_t n) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash))));
+        if (mask != 0) return i + std::countr_zero(mask);
+    }
+    return i + findStringSpecialScalar(p + i, n - i);
+}
+
+JSON_TARGET_AVX2 inline size_t findNonWhitespaceAvx2(const char* p, size_t n) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i ws = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, lf), _mm256_cmpeq_epi8(chunk, cr)));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(ws));
+        if (mask != 0) return i + std::countr_zero(mask);
+    }
+    return i + findNonWhitespaceSse2(p + i, n - i);
+}
+
+JSON_TARGET_AVX2 inline size_t findStringSpecialAvx2(const char* p, size_t n) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash))));
+        if (mask != 0) return i + std::countr_zero(mask);
+    }
+    return i + findStringSpecialSse2(p + i, n - i);
+}
+
+inline bool cpuSupportsAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // JSON_SIMD_X86
+
+// 扫描内核：进程内只选择一次
+struct ScanKernels {
+    size_t (*findNonWhitespace)(const char*, size_t);
+    size_t (*findStringSpecial)(const char*, size_t);
+};
+
+inline const ScanKernels& scanKernels() {
+    static const ScanKernels kernels = [] {
+#if JSON_SIMD_X86
+        if (cpuSupportsAvx2()) {
+            return ScanKernels{findNonWhitespaceAvx2, findStringSpecialAvx2};
+        }
+        return ScanKernels{findNonWhitespaceSse2, findStringSpecialSse2};
+#else
+        return ScanKernels{findNonWhitespaceScalar, findStringSpecialScalar};
+#endif
+    }();
+    return kernels;
+}
+
+inline void skipWhitespace(std::string_view str, size_t& pos) {
+    // 紧凑JSON里大多数位置根本没有空白，先做一次标量判断
+    if (pos >= str.length() || !isWhitespace(str[pos])) return;
+    pos += scanKernels().findNonWhitespace(str.data() + pos, str.length() - pos);
+}
+
+// 读取字符串内容并处理转义；进入时pos指向开头的引号，返回时指向闭合引号之后。
+// 两个特殊字符之间的普通字符整段追加，而不是逐字节追加
+template <typename String>
+void readString(std::string_view str, size_t& pos, String& result) {
+    ++pos; // skip opening quote
+    const auto findStringSpecial = scanKernels().findStringSpecial;
+    
+    while (true) {
+        size_t run = findStringSpecial(str.data() + pos, str.length() - pos);
+        result.append(str.data() + pos, run);
+        pos += run;
+        
+        if (pos + 1 >= str.length()) {
+            // 没有闭合引号，或以单独的反斜杠结尾
+            if (pos < str.length() && str[pos] == '"') break;
+            throw std::runtime_error("Unterminated string");
+        }
+        if (str[pos] == '"') break;
+        
+        ++pos; // skip backslash
+        char escaped = str[pos];
+        switch (escaped) {
+            case '"': result += '"'; break;
+            case '\\': result += '\\'; break;
+            case '/': result += '/'; break;
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            default: result += escaped; break;
+        }
+        ++pos;
+    }
+    
+    ++pos; // skip closing quote
+}
+
+template <typename String>
+void appendEscaped(String& out, std::string_view str) {
+    for (char c : str) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c; break;
+        }
+    }
+}
+
+} // namespace detail
+
 // JSON值类
+// 所有容器都使用多态分配器(std::pmr)，整棵DOM树可以从同一个内存池分配。
+// 复制构造得到的副本总是回到默认堆上，赋值则保留目标对象自己的内存池。
 class Value {
 public:
-    using Object = std::map<std::string, Value>;
-    using Array = std::vector<Value>;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+    using String = std::pmr::string;
+    using Array = std::pmr::vector<Value>;
+    using Object = std::pmr::map<String, Value, std::less<>>;
     
 private:
     ValueType type_;
-    std::variant<std::nullptr_t, int, double, std::string, bool, Array, Object> value_;
+    std::variant<std::nullptr_t, int, double, String, bool, Array, Object> value_;
+    std::pmr::memory_resource* resource_;
     
 public:
     // 构造函数
-    Value() : type_(nullValue), value_(nullptr) {}
-    Value(int val) : type_(intValue), value_(val) {}
-    Value(int64_t val) : type_(intValue), value_(static_cast<int>(val)) {}
-    Value(double val) : type_(realValue), value_(val) {}
-    Value(const std::string& val) : type_(stringValue), value_(val) {}
-    Value(const char* val) : type_(stringValue), value_(std::string(val)) {}
-    Value(bool val) : type_(booleanValue), value_(val) {}
-    Value(const Array& val) : type_(arrayValue), value_(val) {}
-    Value(const Object& val) : type_(objectValue), value_(val) {}
-    Value(ValueType type) : type_(type) {
+    Value() : type_(nullValue), value_(nullptr), resource_(std::pmr::get_default_resource()) {}
+    explicit Value(const allocator_type& alloc) 
+        : type_(nullValue), value_(nullptr), resource_(alloc.resource()) {}
+    Value(int val, const allocator_type& alloc = {}) 
+        : type_(intValue), value_(val), resource_(alloc.resource()) {}
+    Value(int64_t val, const allocator_type& alloc = {}) 
+        : type_(intValue), value_(static_cast<int>(val)), resource_(alloc.resource()) {}
+    Value(double val, const allocator_type& alloc = {}) 
+        : type_(realValue), value_(val), resource_(alloc.resource()) {}
+    Value(const std::string& val, const allocator_type& alloc = {}) 
+        : type_(stringValue), value_(std::in_place_type<String>, val.data(), val.size(), alloc), 
+          resource_(alloc.resource()) {}
+    Value(std::string_view val, const allocator_type& alloc = {}) 
+        : type_(stringValue), value_(std::in_place_type<String>, val.data(), val.size(), alloc), 
+          resource_(alloc.resource()) {}
+    Value(const char* val, const allocator_type& alloc = {}) 
+        : type_(stringValue), value_(std::in_place_type<String>, val, alloc), resource_(alloc.resource()) {}
+    Value(String&& val) 
+        : type_(stringValue), resource_(val.get_allocator().resource()) {
+        value_.emplace<String>(std::move(val));
+    }
+    Value(bool val, const allocator_type& alloc = {}) 
+        : type_(booleanValue), value_(val), resource_(alloc.resource()) {}
+    Value(const Array& val, const allocator_type& alloc = {}) 
+        : type_(arrayValue), value_(std::in_place_type<Array>, val, alloc), resource_(alloc.resource()) {}
+    Value(const Object& val, const allocator_type& alloc = {}) 
+        : type_(objectValue), value_(std::in_place_type<Object>, val, alloc), resource_(alloc.resource()) {}
+    Value(ValueType type, const allocator_type& alloc = {}) : type_(type), resource_(alloc.resource()) {
         switch (type) {
             case nullValue: value_ = nullptr; break;
             case intValue: value_ = 0; break;
             case realValue: value_ = 0.0; break;
-            case stringValue: value_ = std::string(); break;
+            case stringValue: value_.emplace<String>(alloc); break;
             case booleanValue: value_ = false; break;
-            case arrayValue: value_ = Array(); break;
-            case objectValue: value_ = Object(); break;
+            case arrayValue: value_.emplace<Array>(alloc); break;
+            case objectValue: value_.emplace<Object>(alloc); break;
+        }
+    }
+    
+    // 复制/移动（支持指定分配器，供pmr容器做uses-allocator构造）
+    Value(const Value& other) : Value(other, allocator_type()) {}
+    
+    Value(const Value& other, const allocator_type& alloc) : type_(other.type_), resource_(alloc.resource()) {
+        switch (type_) {
+            case stringValue: value_.emplace<String>(std::get<String>(other.value_), alloc); break;
+            case arrayValue: value_.emplace<Array>(std::get<Array>(other.value_), alloc); break;
+            case objectValue: value_.emplace<Object>(std::get<Object>(other.value_), alloc); break;
+            default: value_ = other.value_; break;
         }
     }
     
+    Value(Value&& other) noexcept 
+        : type_(other.type_), value_(std::move(other.value_)), resource_(other.resource_) {}
+    
+    Value(Value&& other, const allocator_type& alloc) : type_(other.type_), resource_(alloc.resource()) {
+        switch (type_) {
+            case stringValue: value_.emplace<String>(std::move(std::get<String>(other.value_)), alloc); break;
+            case arrayValue: value_.emplace<Array>(std::move(std::get<Array>(other.value_)), alloc); break;
+            case objectValue: value_.emplace<Object>(std::move(std::get<Object>(other.value_)), alloc); break;
+            default: value_ = other.value_; break;
+        }
+    }
+    
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            Value copy(other, get_allocator());
+            type_ = copy.type_;
+            value_ = std::move(copy.value_);
+        }
+        return *this;
+    }
+    
+    Value& operator=(Value&& other) {
+        if (this != &other) {
+            if (resource_ == other.resource_ || resource_->is_equal(*other.resource_)) {
+                type_ = other.type_;
+                value_ = std::move(other.value_);
+            } else {
+                // 不同内存池之间只能逐元素搬迁到自己的内存池
+                Value moved(std::move(other), get_allocator());
+                type_ = moved.type_;
+                value_ = std::move(moved.value_);
+            }
+        }
+        return *this;
+    }
+    
+    allocator_type get_allocator() const { return allocator_type(resource_); }
+    
     // 类型检查
     ValueType type() const { return type_; }
     bool isNull() const { return type_ == nullValue; }
@@ -71,19 +344,22 @@ public:
     int asInt() const {
         if (type_ == intValue) return std::get<int>(value_);
         if (type_ == realValue) return static_cast<int>(std::get<double>(value_));
-        if (type_ == stringValue) return std::stoi(std::get<std::string>(value_));
+        if (type_ == stringValue) return std::stoi(asString());
         return 0;
     }
     
     double asDouble() const {
         if (type_ == realValue) return std::get<double>(value_);
         if (type_ == intValue) return static_cast<double>(std::get<int>(value_));
-        if (type_ == stringValue) return std::stod(std::get<std::string>(value_));
+        if (type_ == stringValue) return std::stod(asString());
         return 0.0;
     }
     
     std::string asString() const {
-        if (type_ == stringValue) return std::get<std::string>(value_);
+        if (type_ == stringValue) {
+            const String& str = std::get<String>(value_);
+            return std::string(str.data(), str.size());
+        }
         if (type_ == intValue) return std::to_string(std::get<int>(value_));
         if (type_ == realValue) return std::to_string(std::get<double>(value_));
         if (type_ == booleanValue) return std::get<bool>(value_) ? "true" : "false";
@@ -94,7 +370,7 @@ public:
         if (type_ == booleanValue) return std::get<bool>(value_);
         if (type_ == intValue) return std::get<int>(value_) != 0;
         if (type_ == stringValue) {
-            const std::string& str = std::get<std::string>(value_);
+            const String& str = std::get<String>(value_);
             return str == "true" || str == "1";
         }
         return false;
@@ -106,11 +382,7 @@ public:
     
     // 数组操作
     Value& operator[](int index) {
-        if (type_ != arrayValue) {
-            type_ = arrayValue;
-            value_ = Array();
-        }
-        Array& arr = std::get<Array>(value_);
+        Array& arr = asArray();
         while (arr.size() <= static_cast<size_t>(index)) {
             arr.emplace_back();
         }
@@ -126,11 +398,21 @@ public:
     }
     
     void append(const Value& val) {
-        if (type_ != arrayValue) {
-            type_ = arrayValue;
-            value_ = Array();
-        }
-        std::get<Array>(value_).push_back(val);
+        asArray().push_back(val);
+    }
+    
+    void append(Value&& val) {
+        asArray().push_back(std::move(val));
+    }
+    
+    // 原地构造数组元素，参数直接转发给Value的构造函数（并自动带上本对象的分配器）
+    template <typename... Args>
+    Value& emplaceBack(Args&&... args) {
+        return asArray().emplace_back(std::forward<Args>(args)...);
+    }
+    
+    void reserve(size_t count) {
+        asArray().reserve(count);
     }
     
     size_t size() const {
@@ -140,15 +422,21 @@ public:
     }
     
     // 对象操作
-    Value& operator[](const std::string& key) {
+    Value& operator[](std::string_view key) {
         if (type_ != objectValue) {
             type_ = objectValue;
-            value_ = Object();
+            value_.emplace<Object>(get_allocator());
+        }
+        Object& obj = std::get<Object>(value_);
+        auto it = obj.find(key);
+        if (it == obj.end()) {
+            it = obj.emplace(std::piecewise_construct, 
+                             std::forward_as_tuple(key), std::forward_as_tuple()).first;
         }
-        return std::get<Object>(value_)[key];
+        return it->second;
     }
     
-    const Value& operator[](const std::string& key) const {
+    const Value& operator[](std::string_view key) const {
         static Value nullVal;
         if (type_ != objectValue) return nullVal;
         const Object& obj = std::get<Object>(value_);
@@ -156,12 +444,37 @@ public:
         return (it != obj.end()) ? it->second : nullVal;
     }
     
+    // 原地构造对象成员；键已存在时替换其值。返回新成员的引用，便于继续填充子数组/子对象
+    template <typename... Args>
+    Value& emplace(std::string_view key, Args&&... args) {
+        if (type_ != objectValue) {
+            type_ = objectValue;
+            value_.emplace<Object>(get_allocator());
+        }
+        Object& obj = std::get<Object>(value_);
+        auto it = obj.find(key);
+        if (it != obj.end()) {
+            it->second = Value(std::forward<Args>(args)..., get_allocator());
+            return it->second;
+        }
+        return obj.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                           std::forward_as_tuple(std::forward<Args>(args)...)).first->second;
+    }
+    
+    Value& operator[](const std::string& key) {
+        return operator[](std::string_view(key));
+    }
+    
+    const Value& operator[](const std::string& key) const {
+        return operator[](std::string_view(key));
+    }
+    
     Value& operator[](const char* key) {
-        return operator[](std::string(key));
+        return operator[](std::string_view(key));
     }
     
     const Value& operator[](const char* key) const {
-        return operator[](std::string(key));
+        return operator[](std::string_view(key));
     }
     
     // 迭代器支持
@@ -275,6 +588,14 @@ public:
     }
     
 private:
+    Array& asArray() {
+        if (type_ != arrayValue) {
+            type_ = arrayValue;
+            value_.emplace<Array>(get_allocator());
+        }
+        return std::get<Array>(value_);
+    }
+    
     void serialize(std::ostringstream& oss) const {
         switch (type_) {
             case nullValue:
@@ -287,7 +608,7 @@ private:
                 oss << std::get<double>(value_);
                 break;
             case stringValue:
-                oss << '"' << escapeString(std::get<std::string>(value_)) << '"';
+                oss << '"' << escapeString(std::get<String>(value_)) << '"';
                 break;
             case booleanValue:
                 oss << (std::get<bool>(value_) ? "true" : "false");
@@ -318,27 +639,20 @@ private:
         }
     }
     
-    std::string escapeString(const std::string& str) const {
+    std::string escapeString(std::string_view str) const {
         std::string result;
-        for (char c : str) {
-            switch (c) {
-                case '"': result += "\\\""; break;
-                case '\\': result += "\\\\"; break;
-                case '\b': result += "\\b"; break;
-                case '\f': result += "\\f"; break;
-                case '\n': result += "\\n"; break;
-                case '\r': result += "\\r"; break;
-                case '\t': result += "\\t"; break;
-                default: result += c; break;
-            }
-        }
+        detail::appendEscaped(result, str);
         return result;
     }
 };
 
 // 简化的JSON解析器
+// 可指定内存资源：传入单调内存池时，解析出的字符串、数组和对象节点都从池中分配
 class Reader {
 public:
+    explicit Reader(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : alloc_(resource) {}
+    
     bool parse(const std::string& document, Value& root) {
         try {
             size_t pos = 0;
@@ -350,6 +664,8 @@ public:
     }
     
 private:
+    Value::allocator_type alloc_;
+    
     Value parseValue(const std::string& str, size_t& pos) {
         skipWhitespace(str, pos);
         
@@ -377,7 +693,7 @@ private:
     }
     
     Value parseObject(const std::string& str, size_t& pos) {
-        Value obj(objectValue);
+        Value obj(objectValue, alloc_);
         ++pos; // skip '{'
         
         skipWhitespace(str, pos);
@@ -393,7 +709,7 @@ private:
             if (str[pos] != '"') {
                 throw std::runtime_error("Expected string key");
             }
-            std::string key = parseString(str, pos).asString();
+            Value::String key = parseRawString(str, pos);
             
             skipWhitespace(str, pos);
             if (pos >= str.length() || str[pos] != ':') {
@@ -402,7 +718,7 @@ private:
             ++pos;
             
             // Parse value
-            obj[key] = parseValue(str, pos);
+            obj.emplace(key, parseValue(str, pos));
             
             skipWhitespace(str, pos);
             if (pos >= str.length()) break;
@@ -421,7 +737,7 @@ private:
     }
     
     Value parseArray(const std::string& str, size_t& pos) {
-        Value arr(arrayValue);
+        Value arr(arrayValue, alloc_);
         ++pos; // skip '['
         
         skipWhitespace(str, pos);
@@ -450,36 +766,13 @@ private:
     }
     
     Value parseString(const std::string& str, size_t& pos) {
-        ++pos; // skip opening quote
-        std::string result;
-        
-        while (pos < str.length() && str[pos] != '"') {
-            if (str[pos] == '\\' && pos + 1 < str.length()) {
-                ++pos;
-                char escaped = str[pos];
-                switch (escaped) {
-                    case '"': result += '"'; break;
-                    case '\\': result += '\\'; break;
-                    case '/': result += '/'; break;
-                    case 'b': result += '\b'; break;
-                    case 'f': result += '\f'; break;
-                    case 'n': result += '\n'; break;
-                    case 'r': result += '\r'; break;
-                    case 't': result += '\t'; break;
-                    default: result += escaped; break;
-                }
-            } else {
-                result += str[pos];
-            }
-            ++pos;
-        }
-        
-        if (pos >= str.length()) {
-            throw std::runtime_error("Unterminated string");
-        }
-        
-        ++pos; // skip closing quote
-        return Value(result);
+        return Value(parseRawString(str, pos));
+    }
+    
+    Value::String parseRawString(const std::string& str, size_t& pos) {
+        Value::String result(alloc_);
+        detail::readString(str, pos, result);
+        return result;
     }
     
     Value parseNumber(const std::string& str, size_t& pos) {
@@ -511,22 +804,25 @@ private:
             }
         }
         
-        std::string numStr = str.substr(start, pos - start);
-        
+        // 直接在原文上转换，避免为每个数字构造临时字符串
         if (isDouble) {
-            return Value(std::stod(numStr));
-        } else {
-            return Value(std::stoi(numStr));
+            return Value(std::strtod(str.c_str() + start, nullptr), alloc_);
         }
+        int number = 0;
+        auto [end, ec] = std::from_chars(str.data() + start, str.data() + pos, number);
+        if (ec != std::errc() || end != str.data() + pos) {
+            throw std::runtime_error("Invalid number");
+        }
+        return Value(number, alloc_);
     }
     
     Value parseBool(const std::string& str, size_t& pos) {
         if (str.substr(pos, 4) == "true") {
             pos += 4;
-            return Value(true);
+            return Value(true, alloc_);
         } else if (str.substr(pos, 5) == "false") {
             pos += 5;
-            return Value(false);
+            return Value(false, alloc_);
         }
         throw std::runtime_error("Invalid boolean value");
     }
@@ -534,17 +830,37 @@ private:
     Value parseNull(const std::string& str, size_t& pos) {
         if (str.substr(pos, 4) == "null") {
             pos += 4;
-            return Value();
+            return Value(alloc_);
         }
         throw std::runtime_error("Invalid null value");
     }
     
     void skipWhitespace(const std::string& str, size_t& pos) {
-        while (pos < str.length() && 
-               (str[pos] == ' ' || str[pos] == '\t' || str[pos] == '\n' || str[pos] == '\r')) {
-            ++pos;
-        }
+        detail::skipWhitespace(str, pos);
+    }
+};
+
+// 基于单调内存池的JSON文档
+// 整棵DOM从少量大块内存中分配，文档析构时一次性释放，不再逐个节点free
+class Document {
+public:
+    explicit Document(size_t initialSize = 64 * 1024)
+        : arena_(initialSize), root_(Value::allocator_type(&arena_)) {}
+    
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+    
+    bool parse(const std::string& text) {
+        Reader reader(&arena_);
+        return reader.parse(text, root_);
     }
+    
+    Value& root() { return root_; }
+    const Value& root() const { return root_; }
+    
+private:
+    std::pmr::monotonic_buffer_resource arena_;
+    Value root_;
 };
 
 // 简化的JSON写入器
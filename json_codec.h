@@ -0,0 +1,322 @@
+#ifndef JSON_CODEC_H
+#define JSON_CODEC_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
+#include <type_traits>
+#include "json.h"
+#include "symbol.h"
+
+// 类型化JSON读写：根据实体类提供的编译期字段表直接读写JSON文本，
+// 不经过 Json::Value 中间DOM。
+//
+// 实体类需要提供一个静态成员函数返回字段表，例如：
+//     static constexpr auto jsonFields() {
+//         return std::make_tuple(Json::field("id", &User::id), ...);
+//     }
+namespace Json {
+
+// 字段描述：JSON键名 + 成员指针
+template <typename Class, typename T>
+struct Field {
+    using class_type = Class;
+    using value_type = T;
+
+    const char* name;
+    T Class::* member;
+};
+
+template <typename Class, typename T>
+constexpr Field<Class, T> field(const char* name, T Class::* member) {
+    return Field<Class, T>{name, member};
+}
+
+// 所有字段读完后调用：实体可提供 afterRead() 由持久化字段重建派生状态
+template <typename T>
+void finishRead(T& obj) {
+    if constexpr (requires { obj.afterRead(); }) {
+        obj.afterRead();
+    }
+}
+
+// 轻量级扫描器：在原始文本上顺序前进，出错时抛出异常（与Reader一致）
+class Scanner {
+public:
+    explicit Scanner(std::string_view text) : text_(text), pos_(0) {}
+
+    char peek() {
+        detail::skipWhitespace(text_, pos_);
+        if (pos_ >= text_.length()) {
+            throw std::runtime_error("Unexpected end of input");
+        }
+        return text_[pos_];
+    }
+
+    bool atEnd() {
+        detail::skipWhitespace(text_, pos_);
+        return pos_ >= text_.length();
+    }
+
+    // 下一个非空白字符是c时吃掉它并返回true
+    bool consume(char c) {
+        detail::skipWhitespace(text_, pos_);
+        if (pos_ < text_.length() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            throw std::runtime_error(std::string("Expected '") + c + "'");
+        }
+    }
+
+    void readString(std::string& out) {
+        if (peek() != '"') {
+            throw std::runtime_error("Expected string");
+        }
+        out.clear();
+        detail::readString(text_, pos_, out);
+    }
+
+    // 读取数字记号（不做转换），返回其在原文中的视图
+    std::string_view readNumberToken() {
+        peek();
+        size_t start = pos_;
+        if (text_[pos_] == '-') ++pos_;
+        while (pos_ < text_.length() && isNumberChar(text_[pos_])) {
+            ++pos_;
+        }
+        if (pos_ == start) {
+            throw std::runtime_error("Invalid number");
+        }
+        return text_.substr(start, pos_ - start);
+    }
+
+    bool readLiteral(std::string_view literal) {
+        peek();
+        if (text_.substr(pos_, literal.length()) == literal) {
+            pos_ += literal.length();
+            return true;
+        }
+        return false;
+    }
+
+    // 跳过任意一个JSON值（用于字段表中不存在的键）
+    void skipValue() {
+        char c = peek();
+        if (c == '{' || c == '[') {
+            char close = (c == '{') ? '}' : ']';
+            ++pos_;
+            if (consume(close)) return;
+            do {
+                if (c == '{') {
+                    std::string key;
+                    readString(key);
+                    expect(':');
+                }
+                skipValue();
+            } while (consume(','));
+            expect(close);
+        } else if (c == '"') {
+            std::string ignored;
+            readString(ignored);
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            readNumberToken();
+        } else if (!readLiteral("true") && !readLiteral("false") && !readLiteral("null")) {
+            throw std::runtime_error("Invalid JSON value");
+        }
+    }
+
+private:
+    static bool isNumberChar(char c) {
+        return (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-';
+    }
+
+    std::string_view text_;
+    size_t pos_;
+};
+
+namespace detail {
+
+template <typename T>
+T parseInteger(std::string_view token) {
+    T value = 0;
+    auto [end, ec] = std::from_chars(token.data(), token.data() + token.length(), value);
+    if (ec == std::errc() && end == token.data() + token.length()) {
+        return value;
+    }
+    // 带小数或指数的数字按截断处理，与 Value::asInt 行为一致
+    return static_cast<T>(std::strtod(std::string(token).c_str(), nullptr));
+}
+
+// 读取单个字段；类型不匹配时的宽松转换规则与 Value::asXxx 保持一致
+template <typename T>
+void readField(Scanner& in, T& out) {
+    if constexpr (std::is_same_v<T, bool>) {
+        char c = in.peek();
+        if (in.readLiteral("true")) {
+            out = true;
+        } else if (in.readLiteral("false") || in.readLiteral("null")) {
+            out = false;
+        } else if (c == '"') {
+            std::string text;
+            in.readString(text);
+            out = (text == "true" || text == "1");
+        } else {
+            out = parseInteger<long long>(in.readNumberToken()) != 0;
+        }
+    } else if constexpr (std::is_integral_v<T>) {
+        char c = in.peek();
+        if (c == '"') {
+            std::string text;
+            in.readString(text);
+            out = parseInteger<T>(text);
+        } else if (in.readLiteral("null")) {
+            out = 0;
+        } else {
+            out = parseInteger<T>(in.readNumberToken());
+        }
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        if (in.readLiteral("null")) {
+            out.clear();
+        } else {
+            in.readString(out);
+        }
+    } else if constexpr (std::is_same_v<T, Symbol>) {
+        // 驻留后只保留指针，文本读到线程内复用的缓冲区
+        thread_local std::string text;
+        text.clear();
+        if (!in.readLiteral("null")) {
+            in.readString(text);
+        }
+        out = Symbol(text);
+    } else {
+        // 数组字段（如 std::vector<int> borrowHistory）
+        out.clear();
+        if (in.readLiteral("null")) return;
+        in.expect('[');
+        if (in.consume(']')) return;
+        do {
+            typename T::value_type item{};
+            readField(in, item);
+            out.push_back(std::move(item));
+        } while (in.consume(','));
+        in.expect(']');
+    }
+}
+
+template <typename T>
+void writeField(std::string& out, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        out += value ? "true" : "false";
+    } else if constexpr (std::is_integral_v<T>) {
+        char buffer[24];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, end);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        out += '"';
+        appendEscaped(out, value);
+        out += '"';
+    } else if constexpr (std::is_same_v<T, Symbol>) {
+        writeField(out, value.str());
+    } else {
+        out += '[';
+        bool first = true;
+        for (const auto& item : value) {
+            if (!first) out += ',';
+            first = false;
+            writeField(out, item);
+        }
+        out += ']';
+    }
+}
+
+} // namespace detail
+
+// 按字段表把对象写成JSON对象，追加到out末尾
+template <typename T>
+void writeObject(std::string& out, const T& obj) {
+    bool first = true;
+    auto writeMember = [&](const auto& field) {
+        out += first ? "{\"" : ",\"";
+        first = false;
+        out += field.name;
+        out += "\":";
+        detail::writeField(out, obj.*(field.member));
+    };
+    std::apply([&](const auto&... fields) { (writeMember(fields), ...); }, T::jsonFields());
+    out += first ? "{}" : "}";
+}
+
+// 把一组实体指针（裸指针或智能指针）写成JSON数组
+template <typename Range>
+void writeArray(std::string& out, const Range& items) {
+    out += '[';
+    bool first = true;
+    for (const auto& item : items) {
+        if (!first) out += ',';
+        first = false;
+        writeObject(out, *item);
+    }
+    out += ']';
+}
+
+// 从扫描器读取一个JSON对象并填充到obj；字段表中没有的键被跳过，缺失的键保持原值，最后调用finishRead
+template <typename T>
+void readObject(Scanner& in, T& obj) {
+    in.expect('{');
+    if (in.consume('}')) {
+        finishRead(obj);
+        return;
+    }
+
+    std::string key;
+    do {
+        in.readString(key);
+        in.expect(':');
+        auto readMember = [&](const auto& field) {
+            if (key != field.name) return false;
+            detail::readField(in, obj.*(field.member));
+            return true;
+        };
+        bool matched = std::apply([&](const auto&... fields) { return (readMember(fields) || ...); },
+                                  T::jsonFields());
+        if (!matched) {
+            in.skipValue();
+        }
+    } while (in.consume(','));
+    in.expect('}');
+    finishRead(obj);
+}
+
+// 逐个读取顶层数组的元素，每个元素交给handler(Scanner&)自行解析。
+// 空文档视为空数组；格式错误时返回false（已处理的元素不会回滚）。
+template <typename Handler>
+bool readArray(std::string_view text, Handler&& handler) {
+    try {
+        Scanner in(text);
+        if (in.atEnd()) return true;
+        in.expect('[');
+        if (!in.consume(']')) {
+            do {
+                handler(in);
+            } while (in.consume(','));
+            in.expect(']');
+        }
+        return in.atEnd();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+} // namespace Json
+
+#endif // JSON_CODEC_H
@@ -1,4 +1,6 @@
 #include "library_system.h"
+#include "snapshot.h"
+#include "local_time.h"
 #include <filesystem>
 #include <iostream>
 #include <fstream>
@@ -6,12 +8,135 @@
 #include <iomanip>
 #include <algorithm>
 #include <regex>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace {
+
+// 每个线程至少分到这么多条记录才值得并行
+constexpr size_t MIN_RECORDS_PER_THREAD = 8192;
+
+// 导出books.json时每攒够这么多字节写一次文件
+constexpr size_t EXPORT_CHUNK_BYTES = 1 << 20;
+
+unsigned hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+constexpr int64_t HOUR_SECONDS = 3600;
+constexpr int64_t DAY_SECONDS = 24 * HOUR_SECONDS;
+constexpr int64_t WEEK_SECONDS = 7 * DAY_SECONDS;
+// 1970-01-01是星期四，加上3天使周桶从星期一开始
+constexpr int64_t MONDAY_ALIGNMENT = 3 * DAY_SECONDS;
+
+// 一次性读入整个文件，交给 Json::readArray 直接解析
+std::string readStream(std::istream& in) {
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+// 把JSON数组文件解析到out；文件不存在视为空数组，格式错误时返回false且out不变
+template <typename T>
+bool readJsonFile(const std::string& path, std::vector<std::unique_ptr<T>>& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return !std::filesystem::exists(path);
+    }
+    std::vector<std::unique_ptr<T>> items;
+    bool ok = Json::readArray(readStream(file), [&items](Json::Scanner& in) {
+        auto item = std::make_unique<T>();
+        Json::readObject(in, *item);
+        items.push_back(std::move(item));
+    });
+    if (ok) {
+        out = std::move(items);
+    }
+    return ok;
+}
+
+// 导出清单中的一项：某个JSON文件导出完成时的修改时间和大小
+struct ExportStamp {
+    std::string file;
+    long long modified = 0;
+    long long size = 0;
+
+    static constexpr auto jsonFields() {
+        return std::make_tuple(
+            Json::field("file", &ExportStamp::file),
+            Json::field("modified", &ExportStamp::modified),
+            Json::field("size", &ExportStamp::size));
+    }
+};
+
+// 文件不存在时返回false
+bool stampFile(const std::string& path, ExportStamp& stamp) {
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    stamp.file = path;
+    stamp.modified = static_cast<long long>(modified.time_since_epoch().count());
+    stamp.size = static_cast<long long>(size);
+    return true;
+}
+
+template <typename T>
+using HandleIndex = std::unordered_map<int, typename SlotMap<T>::Handle>;
+
+// 把实体移入实体池并登记id；id重复时索引指向先放入的那个，与原先按顺序查找的结果一致
+template <typename T>
+T* insertEntity(SlotMap<T>& pool, HandleIndex<T>& index, T&& entity) {
+    auto handle = pool.emplace(std::move(entity));
+    T* stored = pool.get(handle);
+    index.emplace(stored->getId(), handle);
+    return stored;
+}
+
+template <typename T>
+T* findEntity(SlotMap<T>& pool, const HandleIndex<T>& index, int id) {
+    auto it = index.find(id);
+    return it == index.end() ? nullptr : pool.get(it->second);
+}
+
+// 用加载出的实体整体替换实体池和id索引，边移入边释放原对象
+template <typename T>
+void replaceEntities(SlotMap<T>& pool, HandleIndex<T>& index, std::vector<std::unique_ptr<T>>& items) {
+    pool.clear();
+    index.clear();
+    pool.reserve(items.size());
+    index.reserve(items.size());
+    for (auto& item : items) {
+        insertEntity(pool, index, std::move(*item));
+        item.reset();
+    }
+    items.clear();
+}
+
+// 实体池复用槽位后遍历顺序不再按id；先线性检查，已有序时不排序
+template <typename T>
+void sortById(std::vector<T*>& items) {
+    auto byId = [](const T* a, const T* b) { return a->getId() < b->getId(); };
+    if (!std::is_sorted(items.begin(), items.end(), byId)) {
+        std::sort(items.begin(), items.end(), byId);
+    }
+}
+
+} // namespace
 
 // User类实现
 std::string User::toString() const {
     std::ostringstream oss;
     oss << "User[ID:" << id << ", Name:" << name << ", Email:" << email 
-        << ", Phone:" << phone << ", Borrowed:" << borrowHistory.size() << "]";
+        << ", Phone:" << phone << ", Borrowed:" << activeLoans.size() << "]";
     return oss.str();
 }
 
@@ -24,11 +149,11 @@ Json::Value User::toJson() const {
     json["maxBorrowCount"] = maxBorrowCount;
     json["createTime"] = static_cast<int64_t>(createTime);
     
-    Json::Value historyArray(Json::arrayValue);
-    for (int bookId : borrowHistory) {
-        historyArray.append(bookId);
+    Json::Value& loanArray = json.emplace("borrowHistory", Json::arrayValue);
+    loanArray.reserve(activeLoans.size());
+    for (int bookId : activeLoans) {
+        loanArray.emplaceBack(bookId);
     }
-    json["borrowHistory"] = historyArray;
     
     return json;
 }
@@ -41,10 +166,9 @@ void User::fromJson(const Json::Value& json) {
     maxBorrowCount = json["maxBorrowCount"].asInt();
     createTime = static_cast<std::time_t>(json["createTime"].asInt64());
     
-    borrowHistory.clear();
-    const Json::Value& historyArray = json["borrowHistory"];
-    for (const auto& item : historyArray) {
-        borrowHistory.push_back(item.asInt());
+    activeLoans.clear();
+    for (const auto& item : json["borrowHistory"]) {
+        activeLoans.push_back(item.asInt());
     }
 }
 
@@ -54,36 +178,37 @@ void User::display() const {
     std::cout << "  姓名: " << name << std::endl;
     std::cout << "  邮箱: " << email << std::endl;
     std::cout << "  电话: " << phone << std::endl;
-    std::cout << "  当前借阅: " << borrowHistory.size() << "/" << maxBorrowCount << std::endl;
+    std::cout << "  当前借阅: " << activeLoans.size() << "/" << maxBorrowCount << std::endl;
 }
 
+// 在借图书只有几本且内联存放，线性查找只扫一条缓存行
 void User::addBorrowRecord(int bookId) {
-    auto it = std::find(borrowHistory.begin(), borrowHistory.end(), bookId);
-    if (it == borrowHistory.end()) {
-        borrowHistory.push_back(bookId);
+    auto it = std::find(activeLoans.begin(), activeLoans.end(), bookId);
+    if (it == activeLoans.end()) {
+        activeLoans.push_back(bookId);
     }
 }
 
 void User::removeBorrowRecord(int bookId) {
-    auto it = std::find(borrowHistory.begin(), borrowHistory.end(), bookId);
-    if (it != borrowHistory.end()) {
-        borrowHistory.erase(it);
+    auto it = std::find(activeLoans.begin(), activeLoans.end(), bookId);
+    if (it != activeLoans.end()) {
+        activeLoans.erase(it);
     }
 }
 
-bool User::canBorrow() const {
-    return borrowHistory.size() < static_cast<size_t>(maxBorrowCount);
+bool User::canBorrow(int count) const {
+    return activeLoans.size() + count <= static_cast<size_t>(maxBorrowCount);
 }
 
 int User::getCurrentBorrowCount() const {
-    return static_cast<int>(borrowHistory.size());
+    return static_cast<int>(activeLoans.size());
 }
 
 // Book类实现
 std::string Book::toString() const {
     std::ostringstream oss;
-    oss << "Book[ID:" << id << ", Title:" << name << ", Author:" << author 
-        << ", Category:" << category << ", Available:" << (isAvailable ? "Yes" : "No") << "]";
+    oss << "Book[ID:" << id << ", Title:" << name << ", Author:" << author.str() 
+        << ", Category:" << category.str() << ", Available:" << shelf.freeCount() << "/" << shelf.size() << "]";
     return oss.str();
 }
 
@@ -91,19 +216,19 @@ Json::Value Book::toJson() const {
     Json::Value json;
     json["id"] = id;
     json["title"] = name;
-    json["author"] = author;
-    json["category"] = category;
+    json["author"] = author.str();
+    json["category"] = category.str();
     json["keywords"] = keywords;
     json["description"] = description;
     json["isAvailable"] = isAvailable;
     json["borrowerId"] = borrowerId;
     json["createTime"] = static_cast<int64_t>(createTime);
     
-    Json::Value historyArray(Json::arrayValue);
-    for (int userId : borrowHistory) {
-        historyArray.append(userId);
+    Json::Value& copyArray = json.emplace("copyBorrowers", Json::arrayValue);
+    copyArray.reserve(copyBorrowers.size());
+    for (int userId : copyBorrowers) {
+        copyArray.emplaceBack(userId);
     }
-    json["borrowHistory"] = historyArray;
     
     return json;
 }
@@ -111,43 +236,92 @@ Json::Value Book::toJson() const {
 void Book::fromJson(const Json::Value& json) {
     id = json["id"].asInt();
     name = json["title"].asString();
-    author = json["author"].asString();
-    category = json["category"].asString();
+    author = Symbol(json["author"].asString());
+    category = Symbol(json["category"].asString());
     keywords = json["keywords"].asString();
     description = json["description"].asString();
     isAvailable = json["isAvailable"].asBool();
     borrowerId = json["borrowerId"].asInt();
     createTime = static_cast<std::time_t>(json["createTime"].asInt64());
     
-    borrowHistory.clear();
-    const Json::Value& historyArray = json["borrowHistory"];
-    for (const auto& item : historyArray) {
-        borrowHistory.push_back(item.asInt());
+    copyBorrowers.clear();
+    for (const auto& item : json["copyBorrowers"]) {
+        copyBorrowers.push_back(item.asInt());
+    }
+    afterRead();
+}
+
+void Book::afterRead() {
+    if (copyBorrowers.size() <= 1) {
+        copyBorrowers.assign(1, isAvailable ? 0 : borrowerId);
+    } else if (copyBorrowers.size() > CopySet::MAX_COPIES) {
+        copyBorrowers.resize(CopySet::MAX_COPIES);
     }
+    rebuildShelf();
+}
+
+void Book::rebuildShelf() {
+    shelf.reset(copyBorrowers.size());
+    for (size_t copy = 0; copy < copyBorrowers.size(); ++copy) {
+        if (copyBorrowers[copy] != 0) {
+            shelf.take(copy);
+        }
+    }
+    syncAvailability();
+}
+
+void Book::syncAvailability() {
+    isAvailable = shelf.any();
+    borrowerId = copyBorrowers.size() == 1 ? copyBorrowers.front() : 0;
 }
 
 void Book::display() const {
     std::cout << "图书信息:" << std::endl;
     std::cout << "  ID: " << id << std::endl;
     std::cout << "  书名: " << name << std::endl;
-    std::cout << "  作者: " << author << std::endl;
-    std::cout << "  类别: " << category << std::endl;
+    std::cout << "  作者: " << author.str() << std::endl;
+    std::cout << "  类别: " << category.str() << std::endl;
     std::cout << "  关键字: " << keywords << std::endl;
     std::cout << "  简介: " << description << std::endl;
-    std::cout << "  状态: " << (isAvailable ? "可借阅" : "已借出") << std::endl;
+    std::cout << "  状态: " << (isAvailable ? "可借阅" : "已借出")
+              << "（在架 " << shelf.freeCount() << "/" << shelf.size() << " 册）" << std::endl;
 }
 
-void Book::borrowBook(int userId) {
-    if (isAvailable) {
-        isAvailable = false;
-        borrowerId = userId;
-        addBorrowHistory(userId);
+int Book::borrowBook(int userId) {
+    size_t copy = shelf.acquire();
+    if (copy == CopySet::npos) {
+        return -1;
     }
+    copyBorrowers[copy] = userId;
+    syncAvailability();
+    return static_cast<int>(copy);
 }
 
-void Book::returnBook() {
-    isAvailable = true;
-    borrowerId = 0;
+bool Book::returnBook(int userId) {
+    // 副本数通常只有几十册，线性查找即可
+    auto it = std::find(copyBorrowers.begin(), copyBorrowers.end(), userId);
+    if (userId == 0 || it == copyBorrowers.end()) {
+        return false;
+    }
+    *it = 0;
+    shelf.release(static_cast<size_t>(it - copyBorrowers.begin()));
+    syncAvailability();
+    return true;
+}
+
+bool Book::isBorrowedBy(int userId) const {
+    return userId != 0 && std::find(copyBorrowers.begin(), copyBorrowers.end(), userId) != copyBorrowers.end();
+}
+
+bool Book::setCopyCount(int copies) {
+    if (copies < 1 || copies > MAX_COPIES || copies < getBorrowedCopyCount()) {
+        return false;
+    }
+    // 借出的副本排在前面，多出的在架副本从末尾去掉；副本编号不对外持久引用，可以重排
+    std::stable_partition(copyBorrowers.begin(), copyBorrowers.end(), [](int userId) { return userId != 0; });
+    copyBorrowers.resize(static_cast<size_t>(copies), 0);
+    rebuildShelf();
+    return true;
 }
 
 bool Book::matchesKeyword(const std::string& keyword) const {
@@ -157,25 +331,16 @@ bool Book::matchesKeyword(const std::string& keyword) const {
     std::string lowerTitle = name;
     std::transform(lowerTitle.begin(), lowerTitle.end(), lowerTitle.begin(), ::tolower);
     
-    std::string lowerAuthor = author;
-    std::transform(lowerAuthor.begin(), lowerAuthor.end(), lowerAuthor.begin(), ::tolower);
-    
-    std::string lowerCategory = category;
-    std::transform(lowerCategory.begin(), lowerCategory.end(), lowerCategory.begin(), ::tolower);
-    
+    // 作者和分类的小写形式在驻留表中只算一次
     std::string lowerKeywords = keywords;
     std::transform(lowerKeywords.begin(), lowerKeywords.end(), lowerKeywords.begin(), ::tolower);
     
     return lowerTitle.find(lowerKeyword) != std::string::npos ||
-           lowerAuthor.find(lowerKeyword) != std::string::npos ||
-           lowerCategory.find(lowerKeyword) != std::string::npos ||
+           author.lower().find(lowerKeyword) != std::string::npos ||
+           category.lower().find(lowerKeyword) != std::string::npos ||
            lowerKeywords.find(lowerKeyword) != std::string::npos;
 }
 
-void Book::addBorrowHistory(int userId) {
-    borrowHistory.push_back(userId);
-}
-
 // BorrowRecord类实现
 void BorrowRecord::returnBook() {
     if (!isReturned) {
@@ -192,6 +357,8 @@ Json::Value BorrowRecord::toJson() const {
     json["borrowTime"] = static_cast<int64_t>(borrowTime);
     json["returnTime"] = static_cast<int64_t>(returnTime);
     json["isReturned"] = isReturned;
+    json["dueTime"] = static_cast<int64_t>(getDueTime());
+    json["reminded"] = reminded;
     return json;
 }
 
@@ -202,6 +369,8 @@ void BorrowRecord::fromJson(const Json::Value& json) {
     borrowTime = static_cast<std::time_t>(json["borrowTime"].asInt64());
     returnTime = static_cast<std::time_t>(json["returnTime"].asInt64());
     isReturned = json["isReturned"].asBool();
+    dueTime = static_cast<std::time_t>(json["dueTime"].asInt64());
+    reminded = json["reminded"].asBool();
 }
 
 std::string BorrowRecord::toString() const {
@@ -212,45 +381,272 @@ std::string BorrowRecord::toString() const {
 }
 
 // Statistics类实现
+Statistics::Statistics()
+    : hourlySeries(HOUR_SECONDS, 14 * 24, LocalTime::cachedUtcOffset()),
+      dailySeries(DAY_SECONDS, 366, LocalTime::cachedUtcOffset()),
+      weeklySeries(WEEK_SECONDS, 104, LocalTime::cachedUtcOffset() + MONDAY_ALIGNMENT),
+      trendingLandmark(std::time(nullptr)),
+      trending(TRENDING_CAPACITY, TRENDING_HALF_LIFE, trendingLandmark) {}
+
 void Statistics::updateBookPopularity(int bookId) {
-    bookPopularity[bookId]++;
+    bookPopularity.add(bookId);
 }
 
 void Statistics::updateUserActivity(int userId) {
-    userActivity[userId]++;
+    userActivity.add(userId);
 }
 
 void Statistics::updateMonthlyStats(std::time_t borrowTime) {
-    std::tm* timeinfo = std::localtime(&borrowTime);
-    std::ostringstream oss;
-    oss << std::put_time(timeinfo, "%Y-%m");
-    monthlyStats[oss.str()]++;
+    monthlyStats[LocalTime::monthKey(borrowTime)]++;
 }
 
-std::vector<std::pair<int, int>> Statistics::getMostPopularBooks(int count) const {
-    std::vector<std::pair<int, int>> result(bookPopularity.begin(), bookPopularity.end());
-    std::sort(result.begin(), result.end(), 
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+void Statistics::updateBorrowSeries(std::time_t borrowTime) {
+    hourlySeries.addBorrow(borrowTime);
+    dailySeries.addBorrow(borrowTime);
+    weeklySeries.addBorrow(borrowTime);
+}
+
+void Statistics::updateReturnSeries(std::time_t returnTime) {
+    hourlySeries.addReturn(returnTime);
+    dailySeries.addReturn(returnTime);
+    weeklySeries.addReturn(returnTime);
+}
+
+void Statistics::updateUserBorrows(int userId) {
+    userLoans[userId].borrows++;
+}
+
+void Statistics::updateUserReturns(int userId, std::time_t borrowTime, std::time_t returnTime, std::time_t dueTime) {
+    UserLoanCounts& counts = userLoans[userId];
+    counts.returns++;
+    counts.loanDays += (std::max<std::time_t>(returnTime - borrowTime, 0) + DAY_SECONDS - 1) / DAY_SECONDS;
+    if (returnTime > dueTime) {
+        counts.lateReturns++;
+    }
+}
+
+void Statistics::updateDistinctCounts(int userId, int bookId, const std::string& category) {
+    bookReaders[bookId].add(static_cast<uint64_t>(userId));
+    userBooks[userId].add(static_cast<uint64_t>(bookId));
+    if (!category.empty()) {
+        categoryReaders[category].add(static_cast<uint64_t>(userId));
+    }
+}
+
+TrendingSketch& Statistics::trendingFor(const std::string& category) {
+    auto it = categoryTrending.find(category);
+    if (it == categoryTrending.end()) {
+        it = categoryTrending.emplace(category, TrendingSketch(TRENDING_CAPACITY, TRENDING_HALF_LIFE, trendingLandmark)).first;
+    }
+    return it->second;
+}
+
+void Statistics::updateTrending(int bookId, const std::string& category, std::time_t borrowTime) {
+    trending.add(bookId, borrowTime);
+    if (!category.empty()) {
+        trendingFor(category).add(bookId, borrowTime);
+    }
+}
+
+void Statistics::updateHeatmap(std::time_t borrowTime) {
+    int64_t days = LocalTime::localDays(borrowTime);
+    int64_t hour = (LocalTime::localSeconds(borrowTime) - days * DAY_SECONDS) / HOUR_SECONDS;
+    int year = LocalTime::civilFromDays(days).year;
+    int64_t dayOfYear = days - LocalTime::daysFromCivil(year, 1, 1);
     
-    if (result.size() > static_cast<size_t>(count)) {
-        result.resize(count);
+    std::vector<int>& cells = borrowHeatmap[year];
+    if (cells.empty()) {
+        cells.resize(HEATMAP_CELLS);
     }
-    return result;
+    cells[static_cast<size_t>(dayOfYear * 24 + hour)]++;
+}
+
+void Statistics::merge(const Statistics& other) {
+    for (const auto& entry : other.bookPopularity.counts()) {
+        bookPopularity.add(entry.first, entry.second);
+    }
+    for (const auto& entry : other.userActivity.counts()) {
+        userActivity.add(entry.first, entry.second);
+    }
+    for (const auto& entry : other.monthlyStats) {
+        monthlyStats[entry.first] += entry.second;
+    }
+    for (const auto& entry : other.bookReaders) {
+        bookReaders[entry.first].merge(entry.second);
+    }
+    for (const auto& entry : other.userBooks) {
+        userBooks[entry.first].merge(entry.second);
+    }
+    for (const auto& entry : other.userLoans) {
+        UserLoanCounts& counts = userLoans[entry.first];
+        counts.borrows += entry.second.borrows;
+        counts.returns += entry.second.returns;
+        counts.loanDays += entry.second.loanDays;
+        counts.lateReturns += entry.second.lateReturns;
+    }
+    for (const auto& entry : other.categoryReaders) {
+        categoryReaders[entry.first].merge(entry.second);
+    }
+    for (const auto& entry : other.borrowHeatmap) {
+        std::vector<int>& cells = borrowHeatmap[entry.first];
+        if (cells.empty()) {
+            cells = entry.second;
+            continue;
+        }
+        for (size_t i = 0; i < HEATMAP_CELLS; ++i) {
+            cells[i] += entry.second[i];
+        }
+    }
+    trending.merge(other.trending);
+    for (const auto& entry : other.categoryTrending) {
+        trendingFor(entry.first).merge(entry.second);
+    }
+    hourlySeries.merge(other.hourlySeries);
+    dailySeries.merge(other.dailySeries);
+    weeklySeries.merge(other.weeklySeries);
+}
+
+std::vector<std::pair<int, int>> Statistics::getMostPopularBooks(int count) const {
+    return bookPopularity.top(static_cast<size_t>(std::max(count, 0)));
 }
 
 std::vector<std::pair<int, int>> Statistics::getMostActiveUsers(int count) const {
-    std::vector<std::pair<int, int>> result(userActivity.begin(), userActivity.end());
-    std::sort(result.begin(), result.end(), 
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+    return userActivity.top(static_cast<size_t>(std::max(count, 0)));
+}
+
+std::map<std::string, int> Statistics::getMonthlyTrends() const {
+    std::map<std::string, int> trends;
+    for (const auto& month : monthlyStats) {
+        trends.emplace_hint(trends.end(), LocalTime::formatMonth(month.first), month.second);
+    }
+    return trends;
+}
+
+double Statistics::estimateBookReaders(int bookId) const {
+    auto it = bookReaders.find(bookId);
+    return it != bookReaders.end() ? it->second.estimate() : 0.0;
+}
+
+Statistics::UserLoanCounts Statistics::getUserLoanCounts(int userId) const {
+    auto it = userLoans.find(userId);
+    return it != userLoans.end() ? it->second : UserLoanCounts{};
+}
+
+double Statistics::estimateUserBooks(int userId) const {
+    auto it = userBooks.find(userId);
+    return it != userBooks.end() ? it->second.estimate() : 0.0;
+}
+
+double Statistics::estimateCategoryReaders(const std::string& category) const {
+    auto it = categoryReaders.find(category);
+    return it != categoryReaders.end() ? it->second.estimate() : 0.0;
+}
+
+Json::Value Statistics::serializeHeatmap(int year) const {
+    Json::Value json;
+    json.emplace("year", year);
     
-    if (result.size() > static_cast<size_t>(count)) {
-        result.resize(count);
+    Json::Value& years = json.emplace("years", Json::arrayValue);
+    for (const auto& entry : borrowHeatmap) {
+        years.emplaceBack(entry.first);
     }
-    return result;
+    
+    Json::Value& days = json.emplace("days", Json::arrayValue);
+    std::vector<int> hourTotals(24);
+    int total = 0;
+    auto it = borrowHeatmap.find(year);
+    if (it != borrowHeatmap.end()) {
+        int64_t firstDay = LocalTime::daysFromCivil(year, 1, 1);
+        for (size_t day = 0; day < 366; ++day) {
+            const int* hours = it->second.data() + day * 24;
+            int dayTotal = 0;
+            for (int hour = 0; hour < 24; ++hour) {
+                dayTotal += hours[hour];
+                hourTotals[hour] += hours[hour];
+            }
+            if (dayTotal == 0) {
+                continue;
+            }
+            total += dayTotal;
+            Json::Value& item = days.emplaceBack(Json::objectValue);
+            item.emplace("date", LocalTime::formatDate(firstDay + static_cast<int64_t>(day)));
+            item.emplace("total", dayTotal);
+            Json::Value& hourly = item.emplace("hours", Json::arrayValue);
+            hourly.reserve(24);
+            for (int hour = 0; hour < 24; ++hour) {
+                hourly.emplaceBack(hours[hour]);
+            }
+        }
+    }
+    
+    Json::Value& hourly = json.emplace("hourTotals", Json::arrayValue);
+    for (int count : hourTotals) {
+        hourly.emplaceBack(count);
+    }
+    json.emplace("total", total);
+    return json;
 }
 
-std::map<std::string, int> Statistics::getMonthlyTrends() const {
-    return monthlyStats;
+std::vector<TrendingSketch::Entry> Statistics::getTrendingBooks(const std::string& category, size_t count,
+                                                                std::time_t now) const {
+    if (category.empty()) {
+        return trending.top(count, now);
+    }
+    auto it = categoryTrending.find(category);
+    return it != categoryTrending.end() ? it->second.top(count, now) : std::vector<TrendingSketch::Entry>();
+}
+
+Json::Value Statistics::serializeTrending(const std::string& category, size_t count, std::time_t now) const {
+    auto toJson = [](Json::Value& list, const std::vector<TrendingSketch::Entry>& entries) {
+        list.reserve(entries.size());
+        for (const auto& entry : entries) {
+            Json::Value& item = list.emplaceBack(Json::objectValue);
+            item.emplace("bookId", entry.key);
+            item.emplace("score", entry.score);
+            item.emplace("error", entry.error);
+        }
+    };
+    
+    Json::Value json;
+    json.emplace("halfLifeSeconds", static_cast<int64_t>(TRENDING_HALF_LIFE));
+    Json::Value& categories = json.emplace("categories", Json::objectValue);
+    if (category.empty()) {
+        toJson(json.emplace("overall", Json::arrayValue), trending.top(count, now));
+        for (const auto& entry : categoryTrending) {
+            toJson(categories.emplace(entry.first, Json::arrayValue), entry.second.top(count, now));
+        }
+    } else {
+        toJson(categories.emplace(category, Json::arrayValue), getTrendingBooks(category, count, now));
+    }
+    return json;
+}
+
+const RollingCounter* Statistics::getTimeSeries(const std::string& granularity) const {
+    if (granularity == "hour") return &hourlySeries;
+    if (granularity == "day") return &dailySeries;
+    if (granularity == "week") return &weeklySeries;
+    return nullptr;
+}
+
+Json::Value Statistics::serializeTimeSeries(const std::string& granularity, size_t buckets, std::time_t now) const {
+    const RollingCounter* series = getTimeSeries(granularity);
+    if (!series) {
+        return Json::Value();
+    }
+    
+    Json::Value json;
+    json.emplace("granularity", granularity);
+    json.emplace("bucketSeconds", series->width());
+    Json::Value& items = json.emplace("buckets", Json::arrayValue);
+    auto range = series->last(buckets, now);
+    items.reserve(range.size());
+    for (const auto& bucket : range) {
+        Json::Value& item = items.emplaceBack(Json::objectValue);
+        item.emplace("start", static_cast<int64_t>(bucket.start));
+        item.emplace("borrows", bucket.borrows);
+        item.emplace("returns", bucket.returns);
+    }
+    return json;
 }
 
 void Statistics::showStatistics() const {
@@ -270,30 +666,50 @@ void Statistics::showStatistics() const {
     
     std::cout << "月度借阅趋势:" << std::endl;
     for (const auto& month : monthlyStats) {
-        std::cout << "  " << month.first << ": " << month.second << " 次借阅" << std::endl;
+        std::cout << "  " << LocalTime::formatMonth(month.first) << ": " << month.second << " 次借阅" << std::endl;
     }
 }
 
 Json::Value Statistics::serialize() const {
     Json::Value json;
     
-    Json::Value bookPop(Json::objectValue);
-    for (const auto& book : bookPopularity) {
-        bookPop[std::to_string(book.first)] = book.second;
+    // 只输出排行榜（前端也只显示前10名），响应大小与图书、用户数量无关
+    Json::Value& bookPop = json.emplace("bookPopularity", Json::objectValue);
+    for (const auto& book : getMostPopularBooks(TOP_K)) {
+        bookPop.emplace(std::to_string(book.first), book.second);
     }
-    json["bookPopularity"] = bookPop;
     
-    Json::Value userAct(Json::objectValue);
-    for (const auto& user : userActivity) {
-        userAct[std::to_string(user.first)] = user.second;
+    Json::Value& userAct = json.emplace("userActivity", Json::objectValue);
+    for (const auto& user : getMostActiveUsers(TOP_K)) {
+        userAct.emplace(std::to_string(user.first), user.second);
     }
-    json["userActivity"] = userAct;
     
-    Json::Value monthly(Json::objectValue);
+    Json::Value& monthly = json.emplace("monthlyStats", Json::objectValue);
     for (const auto& month : monthlyStats) {
-        monthly[month.first] = month.second;
+        monthly.emplace(LocalTime::formatMonth(month.first), month.second);
+    }
+    
+    // 去重计数是估计值：图书和用户只输出排行榜上的条目，分类全部输出
+    Json::Value& readers = json.emplace("distinctReaders", Json::objectValue);
+    for (const auto& book : getMostPopularBooks(TOP_K)) {
+        readers.emplace(std::to_string(book.first), static_cast<int64_t>(std::llround(estimateBookReaders(book.first))));
     }
-    json["monthlyStats"] = monthly;
+    
+    Json::Value& books = json.emplace("distinctBooks", Json::objectValue);
+    for (const auto& user : getMostActiveUsers(TOP_K)) {
+        books.emplace(std::to_string(user.first), static_cast<int64_t>(std::llround(estimateUserBooks(user.first))));
+    }
+    
+    Json::Value& categories = json.emplace("categoryReaders", Json::objectValue);
+    for (const auto& category : categoryReaders) {
+        categories.emplace(category.first, static_cast<int64_t>(std::llround(category.second.estimate())));
+    }
+    
+    // 相对标准误差：约68%的估计落在 真实值×(1±误差) 内，约95%落在两倍误差内
+    Json::Value& errors = json.emplace("distinctCountError", Json::objectValue);
+    errors.emplace("book", HyperLogLog<BOOK_SKETCH_PRECISION>::standardError());
+    errors.emplace("user", HyperLogLog<BOOK_SKETCH_PRECISION>::standardError());
+    errors.emplace("category", HyperLogLog<CATEGORY_SKETCH_PRECISION>::standardError());
     
     return json;
 }
@@ -302,10 +718,36 @@ void Statistics::clear() {
     bookPopularity.clear();
     userActivity.clear();
     monthlyStats.clear();
+    bookReaders.clear();
+    userBooks.clear();
+    userLoans.clear();
+    categoryReaders.clear();
+    borrowHeatmap.clear();
+    trending.clear();
+    categoryTrending.clear();
+    hourlySeries.clear();
+    dailySeries.clear();
+    weeklySeries.clear();
 }
 
 // LibrarySystem类实现
-LibrarySystem::LibrarySystem() : nextUserId(1), nextBookId(1), nextRecordId(1) {
+LibrarySystem::LibrarySystem(bool lazyCatalog)
+    : lazyCatalog(lazyCatalog), nextUserId(1), nextBookId(1), nextRecordId(1),
+      borrowRecords(RECORD_SEGMENTS_DIR), dueDates(DUE_NOTICE_PERIOD), holds(HOLD_PICKUP_WINDOW) {
+    dueSoonHook = [](const DueScheduler::Loan& loan) {
+        std::cout << "到期提醒: 用户 " << loan.userId << " 借阅的图书 " << loan.bookId << " 将于 "
+                  << LocalTime::formatDate(LocalTime::localDays(loan.dueTime)) << " 到期" << std::endl;
+    };
+    dueDates.setDueSoonHook([this](const DueScheduler::Loan& loan) {
+        unsavedReminders.insert(loan.recordId);
+        if (dueSoonHook) {
+            dueSoonHook(loan);
+        }
+    });
+    holds.setReadyHook([](const HoldQueues::Hold& hold) {
+        std::cout << "预约到书: 图书 " << hold.bookId << " 已为用户 " << hold.userId << " 保留至 "
+                  << LocalTime::formatDate(LocalTime::localDays(hold.expiresAt)) << std::endl;
+    });
     createDataDirectory();
     loadData();
 }
@@ -323,29 +765,36 @@ void LibrarySystem::createDataDirectory() {
 }
 
 int LibrarySystem::addUser(const std::string& name, const std::string& email, const std::string& phone) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     if (!validateInput(name) || !validateInput(email)) {
         return -1;
     }
     
-    auto user = std::make_unique<User>(nextUserId++, name, email, phone);
-    int userId = user->getId();
-    users.push_back(std::move(user));
+    int userId = insertEntity(users, userIndex, User(nextUserId++, name, email, phone))->getId();
     saveData();
     return userId;
 }
 
 bool LibrarySystem::deleteUser(int userId) {
-    auto it = std::find_if(users.begin(), users.end(),
-                          [userId](const auto& user) { return user->getId() == userId; });
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto it = userIndex.find(userId);
     
-    if (it != users.end()) {
+    if (it != userIndex.end()) {
         // 检查用户是否有未归还的图书
-        User* user = it->get();
+        User* user = users.get(it->second);
         if (user->getCurrentBorrowCount() > 0) {
             return false; // 不能删除有借阅记录的用户
         }
         
-        users.erase(it);
+        // 撤销该用户的预约；留给他的书顺延给下一位
+        std::time_t now = std::time(nullptr);
+        for (const auto& hold : holds.forUser(userId)) {
+            holds.cancel(hold.bookId, userId);
+            handOffHold(hold.bookId, now);
+        }
+        
+        users.erase(it->second);
+        userIndex.erase(it);
         saveData();
         return true;
     }
@@ -354,6 +803,7 @@ bool LibrarySystem::deleteUser(int userId) {
 
 bool LibrarySystem::updateUser(int userId, const std::string& name, 
                               const std::string& email, const std::string& phone) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     User* user = findUser(userId);
     if (user && validateInput(name) && validateInput(email)) {
         user->setName(name);
@@ -366,61 +816,90 @@ bool LibrarySystem::updateUser(int userId, const std::string& name,
 }
 
 User* LibrarySystem::findUser(int userId) {
-    auto it = std::find_if(users.begin(), users.end(),
-                          [userId](const auto& user) { return user->getId() == userId; });
-    return (it != users.end()) ? it->get() : nullptr;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return findEntity(users, userIndex, userId);
 }
 
 std::vector<User*> LibrarySystem::searchUsers(const std::string& keyword) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     std::vector<User*> result;
     std::string lowerKeyword = keyword;
     std::transform(lowerKeyword.begin(), lowerKeyword.end(), lowerKeyword.begin(), ::tolower);
     
-    for (const auto& user : users) {
-        std::string lowerName = user->getName();
+    for (User& user : users) {
+        std::string lowerName = user.getName();
         std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower);
         
         if (lowerName.find(lowerKeyword) != std::string::npos ||
-            user->getEmail().find(keyword) != std::string::npos) {
-            result.push_back(user.get());
+            user.getEmail().find(keyword) != std::string::npos) {
+            result.push_back(&user);
         }
     }
+    sortById(result);
     return result;
 }
 
 std::vector<User*> LibrarySystem::getAllUsers() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     std::vector<User*> result;
-    for (const auto& user : users) {
-        result.push_back(user.get());
+    result.reserve(users.size());
+    for (User& user : users) {
+        result.push_back(&user);
     }
+    sortById(result);
     return result;
 }
 
 int LibrarySystem::addBook(const std::string& title, const std::string& author,
                           const std::string& category, const std::string& keywords,
-                          const std::string& description) {
-    if (!validateInput(title) || !validateInput(author)) {
-        return -1;
+                          const std::string& description, int copies) {
+    BookInput input{title, author, category, keywords, description, copies};
+    return addBooks(std::span<const BookInput>(&input, 1)).front().id;
+}
+
+std::vector<LibrarySystem::ItemResult> LibrarySystem::addBooks(std::span<const BookInput> inputs) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<ItemResult> results;
+    results.reserve(inputs.size());
+    books.reserve(books.size() + inputs.size());
+    bookIndex.reserve(bookIndex.size() + inputs.size());
+    
+    size_t added = 0;
+    for (const BookInput& input : inputs) {
+        if (!validateInput(input.title) || !validateInput(input.author)) {
+            results.push_back({-1, "书名和作者不能为空且不超过255个字符"});
+            continue;
+        }
+        if (input.copies < 1 || input.copies > Book::MAX_COPIES) {
+            results.push_back({-1, "副本数须在1到" + std::to_string(Book::MAX_COPIES) + "之间"});
+            continue;
+        }
+        Book* book = insertEntity(books, bookIndex, Book(nextBookId++, input.title, input.author, input.category,
+                                                         input.keywords, input.description, input.copies));
+        results.push_back({book->getId(), ""});
+        ++added;
     }
     
-    auto book = std::make_unique<Book>(nextBookId++, title, author, category, keywords, description);
-    int bookId = book->getId();
-    books.push_back(std::move(book));
-    saveData();
-    return bookId;
+    if (added > 0) {
+        saveData();
+    }
+    return results;
 }
 
 bool LibrarySystem::deleteBook(int bookId) {
-    auto it = std::find_if(books.begin(), books.end(),
-                          [bookId](const auto& book) { return book->getId() == bookId; });
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    findBook(bookId); // 延迟目录模式下先物化，删除后其id留在catalogOverrides中
+    auto it = bookIndex.find(bookId);
     
-    if (it != books.end()) {
+    if (it != bookIndex.end()) {
         // 检查图书是否已被借出
-        if (!(*it)->getIsAvailable()) {
-            return false; // 不能删除已借出的图书
+        if (books.get(it->second)->getBorrowedCopyCount() > 0) {
+            return false; // 不能删除还有副本借出的图书
         }
         
-        books.erase(it);
+        holds.dropBook(bookId);
+        books.erase(it->second);
+        bookIndex.erase(it);
         saveData();
         return true;
     }
@@ -429,9 +908,18 @@ bool LibrarySystem::deleteBook(int bookId) {
 
 bool LibrarySystem::updateBook(int bookId, const std::string& title, const std::string& author,
                               const std::string& category, const std::string& keywords,
-                              const std::string& description) {
+                              const std::string& description, int copies) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     Book* book = findBook(bookId);
     if (book && validateInput(title) && validateInput(author)) {
+        // 留给待取书读者的副本也不能去掉
+        if (copies > 0 && copies != book->getCopyCount()) {
+            if (static_cast<size_t>(copies - book->getBorrowedCopyCount()) < holds.readyCount(bookId) ||
+                !book->setCopyCount(copies)) {
+                return false;
+            }
+            handOffHold(bookId, std::time(nullptr));
+        }
         book->setName(title);
         book->setAuthor(author);
         book->setCategory(category);
@@ -444,218 +932,972 @@ bool LibrarySystem::updateBook(int bookId, const std::string& title, const std::
 }
 
 Book* LibrarySystem::findBook(int bookId) {
-    auto it = std::find_if(books.begin(), books.end(),
-                          [bookId](const auto& book) { return book->getId() == bookId; });
-    return (it != books.end()) ? it->get() : nullptr;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (Book* book = findEntity(books, bookIndex, bookId)) {
+        return book;
+    }
+    return catalog ? materializeBook(bookId) : nullptr;
+}
+
+Book* LibrarySystem::materializeBook(int bookId) {
+    // 物化会改动实体池、id索引和覆盖集合，必须与并发的读取和遍历互斥
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (catalogOverrides.count(bookId)) {
+        return nullptr; // 已物化的不会走到这里，剩下的就是已删除的
+    }
+    auto row = catalog->findRow(bookId);
+    if (!row) {
+        return nullptr;
+    }
+    // 物化后的图书常驻内存：调用方持有的Book*必须一直有效，因此不做淘汰。直接解码到实体池的槽位中
+    auto handle = books.emplace();
+    Book* book = books.get(handle);
+    catalog->decode(*row, *book);
+    bookIndex.emplace(bookId, handle);
+    catalogOverrides.insert(bookId);
+    return book;
 }
 
 std::vector<Book*> LibrarySystem::searchBooks(const std::string& keyword) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (catalog) {
+        // 在映射行上匹配，只物化命中的图书
+        std::vector<int> matches;
+        forEachBook([&](const Book& book) {
+            if (book.matchesKeyword(keyword)) {
+                matches.push_back(book.getId());
+            }
+        });
+        std::vector<Book*> result;
+        for (int bookId : matches) {
+            result.push_back(findBook(bookId));
+        }
+        return result;
+    }
+    
     std::vector<Book*> result;
-    for (const auto& book : books) {
-        if (book->matchesKeyword(keyword)) {
-            result.push_back(book.get());
+    for (Book& book : books) {
+        if (book.matchesKeyword(keyword)) {
+            result.push_back(&book);
         }
     }
+    sortById(result);
     return result;
 }
 
 std::vector<Book*> LibrarySystem::getAllBooks() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (catalog) {
+        for (uint32_t row = 0; row < catalog->size(); ++row) {
+            materializeBook(catalog->idAt(row));
+        }
+    }
+    
     std::vector<Book*> result;
-    for (const auto& book : books) {
-        result.push_back(book.get());
+    result.reserve(books.size());
+    for (Book& book : books) {
+        result.push_back(&book);
+    }
+    sortById(result);
+    return result;
+}
+
+size_t LibrarySystem::getBookCount() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!catalog) {
+        return books.size();
+    }
+    return books.size() + catalog->size() - catalogOverrides.size();
+}
+
+std::vector<LibrarySystem::FacetCount> LibrarySystem::getBookFacets(const std::string& field) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    bool byAuthor = field == "author";
+    if (!byAuthor && field != "category") {
+        return {};
+    }
+    
+    // 符号id连续编号，直接作为计数数组的下标
+    std::vector<int> counts(Symbol::count(), 0);
+    forEachBook([&counts, byAuthor](const Book& book) {
+        uint32_t id = (byAuthor ? book.getAuthorSymbol() : book.getCategorySymbol()).id();
+        if (id >= counts.size()) {
+            counts.resize(id + 1, 0); // 遍历期间驻留的新符号
+        }
+        ++counts[id];
+    });
+    
+    std::vector<FacetCount> result;
+    for (uint32_t id = 0; id < counts.size(); ++id) {
+        if (counts[id] > 0) {
+            result.push_back({Symbol::fromId(id).str(), counts[id]});
+        }
     }
+    std::sort(result.begin(), result.end(), [](const FacetCount& a, const FacetCount& b) {
+        return a.count != b.count ? a.count > b.count : a.value < b.value;
+    });
     return result;
 }
 
 bool LibrarySystem::borrowBook(int userId, int bookId) {
+    return borrowBooks(userId, std::span<const int>(&bookId, 1)).front().ok();
+}
+
+bool LibrarySystem::returnBook(int userId, int bookId) {
+    return returnBooks(userId, std::span<const int>(&bookId, 1)).front().ok();
+}
+
+namespace {
+
+// 批量借还校验完后收尾：有失败项时把通过校验的项也标记为未执行
+bool finishBatch(std::vector<LibrarySystem::ItemResult>& results) {
+    bool allPassed = std::all_of(results.begin(), results.end(),
+                                 [](const LibrarySystem::ItemResult& result) { return result.error.empty(); });
+    if (!allPassed) {
+        for (auto& result : results) {
+            if (result.error.empty()) {
+                result = {-1, "同批其他图书未通过校验，未执行"};
+            }
+        }
+    }
+    return allPassed;
+}
+
+} // namespace
+
+std::vector<LibrarySystem::ItemResult> LibrarySystem::borrowBooks(int userId, std::span<const int> bookIds) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<ItemResult> results(bookIds.size(), ItemResult{-1, ""});
     User* user = findUser(userId);
-    Book* book = findBook(bookId);
+    if (!user) {
+        for (auto& result : results) {
+            result.error = "用户不存在";
+        }
+        return results;
+    }
     
-    if (!user || !book) {
-        return false;
+    // 校验要看到过期预约释放后的在架副本；整批被拒时这一变化也要保存
+    std::time_t now = std::time(nullptr);
+    expireHolds(now);
+    
+    // 先校验整批，不改任何状态
+    std::vector<Book*> targets(bookIds.size(), nullptr);
+    int accepted = 0;
+    for (size_t i = 0; i < bookIds.size(); ++i) {
+        int bookId = bookIds[i];
+        Book* book = findBook(bookId);
+        std::string& error = results[i].error;
+        if (!book) {
+            error = "图书不存在";
+        } else if (std::find(bookIds.begin(), bookIds.begin() + i, bookId) != bookIds.begin() + i) {
+            error = "同一批中重复";
+        } else if (book->isBorrowedBy(userId)) {
+            // 同一书目每位读者只借一册
+            error = "已借阅此书";
+        } else if (!book->getIsAvailable()) {
+            error = "没有在架副本";
+        } else if (!holds.isReadyFor(bookId, userId) &&
+                   static_cast<size_t>(book->getAvailableCopyCount()) <= holds.readyCount(bookId)) {
+            // 在架的副本中有几册留给了待取书的读者，其他读者只能借剩下的
+            error = "在架副本已为预约者保留";
+        } else if (!user->canBorrow(accepted + 1)) {
+            error = "超出借阅上限";
+        } else {
+            targets[i] = book;
+            ++accepted;
+        }
+    }
+    if (!finishBatch(results)) {
+        if (unsavedHoldExpiry) {
+            saveData();
+        }
+        return results;
     }
     
-    if (!user->canBorrow() || !book->getIsAvailable()) {
-        return false;
+    for (size_t i = 0; i < bookIds.size(); ++i) {
+        applyBorrow(*user, *targets[i], now);
+        results[i].id = bookIds[i];
+    }
+    dueDates.advance(now);
+    
+    saveData();
+    return results;
+}
+
+std::vector<LibrarySystem::ItemResult> LibrarySystem::returnBooks(int userId, std::span<const int> bookIds) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<ItemResult> results(bookIds.size(), ItemResult{-1, ""});
+    User* user = findUser(userId);
+    if (!user) {
+        for (auto& result : results) {
+            result.error = "用户不存在";
+        }
+        return results;
+    }
+    
+    std::vector<Book*> targets(bookIds.size(), nullptr);
+    for (size_t i = 0; i < bookIds.size(); ++i) {
+        int bookId = bookIds[i];
+        Book* book = findBook(bookId);
+        std::string& error = results[i].error;
+        if (!book) {
+            error = "图书不存在";
+        } else if (std::find(bookIds.begin(), bookIds.begin() + i, bookId) != bookIds.begin() + i) {
+            error = "同一批中重复";
+        } else if (!book->isBorrowedBy(userId)) {
+            error = "该用户未借阅此书";
+        } else {
+            targets[i] = book;
+        }
+    }
+    if (!finishBatch(results)) {
+        return results;
     }
     
+    std::time_t now = std::time(nullptr);
+    for (size_t i = 0; i < bookIds.size(); ++i) {
+        applyReturn(*user, *targets[i], now);
+        results[i].id = bookIds[i];
+    }
+    
+    saveData();
+    return results;
+}
+
+void LibrarySystem::applyBorrow(User& user, Book& book, std::time_t now) {
+    int userId = user.getId();
+    int bookId = book.getId();
+    holds.fulfill(bookId, userId);
+    
     // 执行借阅操作
-    book->borrowBook(userId);
-    user->addBorrowRecord(bookId);
+    book.borrowBook(userId);
+    user.addBorrowRecord(bookId);
     
     // 创建借阅记录
-    auto record = std::make_unique<BorrowRecord>(nextRecordId++, userId, bookId);
-    borrowRecords.push_back(std::move(record));
+    BorrowRecord* record = borrowRecords.add(std::make_unique<BorrowRecord>(
+        nextRecordId++, userId, bookId, now, 0, false, now + BorrowRecord::DEFAULT_LOAN_PERIOD));
+    dueDates.schedule({record->getRecordId(), userId, bookId, record->getDueTime()});
     
     // 更新统计信息
     statistics.updateBookPopularity(bookId);
     statistics.updateUserActivity(userId);
-    statistics.updateMonthlyStats(std::time(nullptr));
-    
-    saveData();
-    return true;
+    statistics.updateUserBorrows(userId);
+    statistics.updateMonthlyStats(now);
+    statistics.updateBorrowSeries(now);
+    statistics.updateDistinctCounts(userId, bookId, book.getCategory());
+    statistics.updateTrending(bookId, book.getCategory(), now);
+    statistics.updateHeatmap(now);
 }
 
-bool LibrarySystem::returnBook(int userId, int bookId) {
-    User* user = findUser(userId);
-    Book* book = findBook(bookId);
+void LibrarySystem::applyReturn(User& user, Book& book, std::time_t now) {
+    int userId = user.getId();
+    int bookId = book.getId();
     
-    if (!user || !book) {
-        return false;
-    }
+    // 执行归还操作
+    book.returnBook(userId);
+    user.removeBorrowRecord(bookId);
     
-    if (book->getIsAvailable() || book->getBorrowerId() != userId) {
-        return false;
+    // 更新借阅记录（未归还的记录都在活动段中）
+    if (BorrowRecord* record = borrowRecords.findOpen(userId, bookId)) {
+        record->returnBook();
+        statistics.updateReturnSeries(record->getReturnTime());
+        statistics.updateUserReturns(userId, record->getBorrowTime(), record->getReturnTime(), record->getDueTime());
+        dueDates.cancel(record->getRecordId());
     }
     
-    // 执行归还操作
-    book->returnBook();
-    user->removeBorrowRecord(bookId);
-    
-    // 更新借阅记录
-    for (const auto& record : borrowRecords) {
-        if (record->getUserId() == userId && record->getBookId() == bookId && !record->getIsReturned()) {
-            record->returnBook();
-            break;
+    // 有人预约时直接留给队首读者
+    handOffHold(bookId, now);
+}
+
+std::vector<BorrowRecord> LibrarySystem::getUserBorrowHistory(int userId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return borrowRecords.byUser(userId);
+}
+
+std::vector<BorrowRecord> LibrarySystem::getBookBorrowHistory(int bookId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return borrowRecords.byBook(bookId);
+}
+
+std::vector<BorrowRecord> LibrarySystem::getAllBorrowRecords() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return borrowRecords.all();
+}
+
+Json::Value LibrarySystem::getUserRecordsJson(int userId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!findUser(userId)) {
+        return Json::Value();
+    }
+    // 已归档的月份也在其中，records.json只含活动段，不能用来展示历史
+    Json::Value json(Json::arrayValue);
+    for (const BorrowRecord& record : borrowRecords.byUser(userId)) {
+        Json::Value& item = json.emplaceBack(record.toJson());
+        const Book* book = findBook(record.getBookId());
+        item["bookTitle"] = book ? book->getName() : std::string();
+    }
+    return json;
+}
+
+Json::Value LibrarySystem::getUserLoanStatsJson(int userId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const User* user = findUser(userId);
+    if (!user) {
+        return Json::Value();
+    }
+    // 累计计数来自统计；当前在借及其中已逾期的按活动段中的未归还记录计算
+    Statistics::UserLoanCounts counts = statistics.getUserLoanCounts(userId);
+    std::time_t now = std::time(nullptr);
+    int current = 0;
+    int overdue = counts.lateReturns;
+    for (int bookId : user->getActiveLoans()) {
+        if (const BorrowRecord* record = borrowRecords.findOpen(userId, bookId)) {
+            current++;
+            overdue += record->isOverdue(now) ? 1 : 0;
         }
     }
     
+    Json::Value json;
+    json["totalBorrows"] = counts.borrows;
+    json["currentBorrows"] = current;
+    json["averageLoanDays"] =
+        counts.returns > 0 ? static_cast<int>((counts.loanDays + counts.returns / 2) / counts.returns) : 0;
+    json["overdueCount"] = overdue;
+    return json;
+}
+
+size_t LibrarySystem::getBorrowRecordCount() const {
+    return borrowRecords.size();
+}
+
+int LibrarySystem::placeHold(int userId, int bookId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    User* user = findUser(userId);
+    Book* book = findBook(bookId);
+    if (!user || !book || book->isBorrowedBy(userId)) {
+        return 0;
+    }
+    
+    // 还有没留给别人的在架副本时直接借即可，无需预约
+    std::time_t now = std::time(nullptr);
+    expireHolds(now);
+    int position = 0;
+    if (static_cast<size_t>(book->getAvailableCopyCount()) <= holds.readyCount(bookId)) {
+        position = holds.place(bookId, userId, now);
+    }
+    if (position > 0 || unsavedHoldExpiry) {
+        saveData();
+    }
+    return position;
+}
+
+bool LibrarySystem::cancelHold(int userId, int bookId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!holds.cancel(bookId, userId)) {
+        return false;
+    }
+    handOffHold(bookId, std::time(nullptr));
     saveData();
     return true;
 }
 
-std::vector<BorrowRecord*> LibrarySystem::getUserBorrowHistory(int userId) {
-    std::vector<BorrowRecord*> result;
-    for (const auto& record : borrowRecords) {
-        if (record->getUserId() == userId) {
-            result.push_back(record.get());
-        }
+std::vector<HoldQueues::Hold> LibrarySystem::getBookHolds(int bookId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    expireHolds(std::time(nullptr));
+    if (unsavedHoldExpiry) {
+        saveData();
+    }
+    return holds.forBook(bookId);
+}
+
+std::vector<HoldQueues::Hold> LibrarySystem::getUserHolds(int userId) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    expireHolds(std::time(nullptr));
+    if (unsavedHoldExpiry) {
+        saveData();
+    }
+    return holds.forUser(userId);
+}
+
+void LibrarySystem::handOffHold(int bookId, std::time_t now) {
+    Book* book = findBook(bookId);
+    if (!book) {
+        return;
+    }
+    while (static_cast<size_t>(book->getAvailableCopyCount()) > holds.readyCount(bookId) && holds.offer(bookId, now)) {
+    }
+}
+
+void LibrarySystem::expireHolds(std::time_t now) {
+    for (int bookId : holds.expire(now)) {
+        handOffHold(bookId, now);
+        unsavedHoldExpiry = true;
+    }
+}
+
+std::vector<DueScheduler::Loan> LibrarySystem::getOverdueLoans() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    pollDueDates();
+    return dueDates.overdue();
+}
+
+std::vector<DueScheduler::Loan> LibrarySystem::getDueSoonLoans() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    pollDueDates();
+    return dueDates.dueSoon();
+}
+
+void LibrarySystem::pollDueDates() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::time_t now = std::time(nullptr);
+    dueDates.advance(now);
+    expireHolds(now);
+    if (!unsavedReminders.empty() || unsavedHoldExpiry) {
+        saveData();
     }
-    return result;
 }
 
-std::vector<BorrowRecord*> LibrarySystem::getBookBorrowHistory(int bookId) {
-    std::vector<BorrowRecord*> result;
-    for (const auto& record : borrowRecords) {
-        if (record->getBookId() == bookId) {
-            result.push_back(record.get());
+void LibrarySystem::setDueSoonHook(DueScheduler::Hook hook) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    dueSoonHook = std::move(hook);
+}
+
+void LibrarySystem::markReminders() {
+    if (unsavedReminders.empty()) {
+        return;
+    }
+    for (const auto& record : borrowRecords.active()) {
+        if (unsavedReminders.count(record->getRecordId())) {
+            record->markReminded();
         }
     }
-    return result;
+    unsavedReminders.clear();
 }
 
-std::vector<BorrowRecord*> LibrarySystem::getAllBorrowRecords() {
-    std::vector<BorrowRecord*> result;
-    for (const auto& record : borrowRecords) {
-        result.push_back(record.get());
+void LibrarySystem::rebuildDueDates() {
+    // 未归还的借阅都在活动段中；已提醒过的借阅带着标记排期，不会再次提醒
+    markReminders();
+    dueDates.clear();
+    for (const auto& record : borrowRecords.active()) {
+        if (!record->getIsReturned()) {
+            dueDates.schedule({record->getRecordId(), record->getUserId(), record->getBookId(), record->getDueTime(),
+                               record->wasReminded()});
+        }
     }
-    return result;
+    dueDates.advance(std::time(nullptr));
 }
 
 Json::Value LibrarySystem::getStatisticsJson() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     return statistics.serialize();
 }
 
+Json::Value LibrarySystem::getTrendingJson(const std::string& category, size_t limit) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return statistics.serializeTrending(category, limit, std::time(nullptr));
+}
+
+Json::Value LibrarySystem::getTimeSeriesJson(const std::string& granularity, size_t buckets) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const RollingCounter* series = statistics.getTimeSeries(granularity);
+    if (!series) {
+        return Json::Value();
+    }
+    return statistics.serializeTimeSeries(granularity, std::min(buckets, series->capacity()), std::time(nullptr));
+}
+
+Json::Value LibrarySystem::getHeatmapJson(int year) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return statistics.serializeHeatmap(year);
+}
+
 void LibrarySystem::saveData() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    markReminders();
+    unsavedHoldExpiry = false;
     try {
-        // 保存用户数据
-        Json::Value usersJson(Json::arrayValue);
-        for (const auto& user : users) {
-            usersJson.append(user->toJson());
+        // 过去月份归还的记录先转入已关闭段，快照和records.json都只含活动段
+        borrowRecords.rollOver(std::time(nullptr));
+        
+        // 快照是主存储，先写；JSON导出随后逐个替换。导出期间清单标记为未完成，
+        // 中途崩溃时启动仍以快照为准，不会把新旧混杂的JSON当作手动修改载入
+        bool snapshotSaved = saveSnapshot();
+        if (!snapshotSaved) {
+            // 快照没写成时去掉清单，启动时按修改时间比较，较新的JSON导出会被采用
+            std::error_code ec;
+            std::filesystem::remove(EXPORT_MANIFEST_FILE, ec);
+        } else if (!Snapshot::writeFileAtomically(EXPORT_MANIFEST_FILE, "[]")) {
+            // 无法标记导出进行中，就不动导出文件，免得它们被误认为手动修改过
+            std::cerr << "写入失败: " << EXPORT_MANIFEST_FILE << std::endl;
+            return;
         }
         
-        std::ofstream usersFile(USERS_FILE);
-        usersFile << usersJson;
-        usersFile.close();
+        if (writeJsonExports() && snapshotSaved) {
+            std::vector<ExportStamp> stamps;
+            for (const auto& path : {USERS_FILE, BOOKS_FILE, RECORDS_FILE, HOLDS_FILE}) {
+                ExportStamp stamp;
+                if (stampFile(path, stamp)) {
+                    stamps.push_back(std::move(stamp));
+                }
+            }
+            std::string text;
+            text += '[';
+            for (const auto& stamp : stamps) {
+                if (text.size() > 1) text += ',';
+                Json::writeObject(text, stamp);
+            }
+            text += ']';
+            if (!Snapshot::writeFileAtomically(EXPORT_MANIFEST_FILE, text)) {
+                std::cerr << "写入失败: " << EXPORT_MANIFEST_FILE << std::endl;
+            }
+        }
         
-        // 保存图书数据
-        Json::Value booksJson(Json::arrayValue);
-        for (const auto& book : books) {
-            booksJson.append(book->toJson());
+    } catch (const std::exception& e) {
+        std::cerr << "保存数据失败: " << e.what() << std::endl;
+    }
+}
+
+bool LibrarySystem::writeJsonExports() {
+    // 按字段表直接序列化，不再构造中间DOM；每个文件都原子替换，
+    // 写到一半崩溃也不会留下截断的文件
+    bool ok = true;
+    auto write = [&ok](const std::string& path, const std::string& text) {
+        if (!Snapshot::writeFileAtomically(path, text)) {
+            std::cerr << "写入失败: " << path << std::endl;
+            ok = false;
         }
+    };
+    std::string text;
+    
+    // 保存图书数据。最先写，写不成就不动其余文件：快照没写成时启动会回退到JSON，
+    // books.json绝不能比users.json和records.json旧，否则借阅会指向丢失的图书。
+    // 目录可能很大（延迟目录模式下还未解码），边遍历边分块写出
+    {
+        Snapshot::AtomicFile file(BOOKS_FILE);
+        bool first = true;
+        text.assign(1, '[');
+        forEachBook([&](const Book& book) {
+            if (!first) text += ',';
+            first = false;
+            Json::writeObject(text, book);
+            if (text.size() >= EXPORT_CHUNK_BYTES) {
+                file.write(text);
+                text.clear();
+            }
+        });
+        text += ']';
+        if (!file.write(text) || !file.commit()) {
+            std::cerr << "写入失败: " << BOOKS_FILE << std::endl;
+            return false;
+        }
+    }
+    
+    // 保存用户数据
+    text.clear();
+    text += '[';
+    for (const User& user : users) {
+        if (text.size() > 1) text += ',';
+        Json::writeObject(text, user);
+    }
+    text += ']';
+    write(USERS_FILE, text);
+    
+    // 保存借阅记录（活动段）
+    text.clear();
+    Json::writeArray(text, borrowRecords.active());
+    write(RECORDS_FILE, text);
+    
+    // 保存预约队列（按排队顺序）
+    text.clear();
+    text += '[';
+    for (const auto& hold : holds.all()) {
+        if (text.size() > 1) text += ',';
+        Json::writeObject(text, hold);
+    }
+    text += ']';
+    write(HOLDS_FILE, text);
+    return ok;
+}
+
+void LibrarySystem::loadData() {
+    try {
+        auto loadStart = std::chrono::steady_clock::now();
+        
+        // 已关闭的借阅记录段只读取段头
+        borrowRecords.open();
         
-        std::ofstream booksFile(BOOKS_FILE);
-        booksFile << booksJson;
-        booksFile.close();
+        // 优先从二进制快照恢复；快照缺失、损坏或JSON文件被手动修改过时从JSON导入
+        bool loaded = false;
+        bool snapshotFirst = std::filesystem::exists(SNAPSHOT_FILE) && !jsonEditedSinceSave();
+        if (snapshotFirst) {
+            loaded = loadSnapshot(SNAPSHOT_FILE);
+        }
+        if (!loaded) {
+            loaded = importJsonData();
+        }
         
-        // 保存借阅记录
-        Json::Value recordsJson(Json::arrayValue);
-        for (const auto& record : borrowRecords) {
-            recordsJson.append(record->toJson());
+        // JSON也损坏时回退到最近一次完好的快照，JSON文件会在下次保存时重写
+        if (!loaded && !snapshotFirst && std::filesystem::exists(SNAPSHOT_FILE)) {
+            loaded = loadSnapshot(SNAPSHOT_FILE);
+        }
+        if (!loaded && std::filesystem::exists(SNAPSHOT_FILE + ".prev")) {
+            loaded = loadSnapshot(SNAPSHOT_FILE + ".prev");
+        }
+        if (!loaded) {
+            quarantineDataFiles();
         }
+        borrowRecords.rollOver(std::time(nullptr));
+        double loadMs = elapsedMs(loadStart);
         
-        std::ofstream recordsFile(RECORDS_FILE);
-        recordsFile << recordsJson;
-        recordsFile.close();
+        auto statisticsStart = std::chrono::steady_clock::now();
+        updateStatistics();
+        double statisticsMs = elapsedMs(statisticsStart);
+        rebuildDueDates();
+        expireHolds(std::time(nullptr));
+        
+        std::cout << std::fixed << std::setprecision(1)
+                  << "启动加载: 读取数据 " << loadMs << " ms, 构建统计 " << statisticsMs << " ms ("
+                  << users.size() << " 用户, " << getBookCount() << " 图书, "
+                  << borrowRecords.size() << " 借阅记录, " << borrowRecords.closedMonths().size()
+                  << " 个已关闭段)" << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
         
     } catch (const std::exception& e) {
-        std::cerr << "保存数据失败: " << e.what() << std::endl;
+        std::cerr << "加载数据失败: " << e.what() << std::endl;
     }
 }
 
-void LibrarySystem::loadData() {
+bool LibrarySystem::loadSnapshot(const std::string& path) {
+    // 延迟目录模式下映射快照，图书按需解码；否则一次读入并校验整个文件
+    auto mapped = std::make_unique<MappedCatalog>();
+    Snapshot::Reader loadedReader;
+    if (lazyCatalog ? !mapped->open(path) : !loadedReader.load(path)) {
+        const std::string& error = lazyCatalog ? mapped->error() : loadedReader.error();
+        std::cerr << "快照不可用(" << error << "): " << path << std::endl;
+        return false;
+    }
+    const Snapshot::Reader& reader = lazyCatalog ? mapped->reader() : loadedReader;
+    
+    std::vector<std::unique_ptr<User>> loadedUsers;
+    std::vector<std::unique_ptr<Book>> loadedBooks;
+    std::vector<std::unique_ptr<BorrowRecord>> loadedRecords;
+    std::vector<std::unique_ptr<HoldQueues::Hold>> loadedHolds;
+    // 早期的快照不含预约表，预约队列仍从holds.json读取
+    bool holdsInSnapshot = reader.findTable("holds") != nullptr;
     try {
-        // 加载用户数据
-        std::ifstream usersFile(USERS_FILE);
-        if (usersFile.is_open()) {
-            Json::Value usersJson;
-            usersFile >> usersJson;
-            
-            for (const auto& userJson : usersJson) {
-                auto user = std::make_unique<User>();
-                user->fromJson(userJson);
-                if (user->getId() >= nextUserId) {
-                    nextUserId = user->getId() + 1;
-                }
-                users.push_back(std::move(user));
+        unsigned threads = hardwareThreads();
+        reader.readTable("users", loadedUsers, threads);
+        if (!lazyCatalog) {
+            reader.readTable("books", loadedBooks, threads);
+        }
+        reader.readTable("records", loadedRecords, threads);
+        reader.readTable("holds", loadedHolds);
+    } catch (const std::exception& e) {
+        std::cerr << "快照内容损坏(" << e.what() << "): " << path << std::endl;
+        return false;
+    }
+    
+    replaceEntities(users, userIndex, loadedUsers);
+    replaceEntities(books, bookIndex, loadedBooks);
+    borrowRecords.replaceActive(std::move(loadedRecords));
+    if (lazyCatalog) {
+        catalog = std::move(mapped);
+        catalogOverrides.clear();
+    }
+    if (!holdsInSnapshot && !readJsonFile(HOLDS_FILE, loadedHolds)) {
+        std::cerr << "预约数据损坏，已忽略: " << HOLDS_FILE << std::endl;
+    }
+    restoreHolds(loadedHolds);
+    updateNextIds();
+    return true;
+}
+
+void LibrarySystem::updateNextIds() {
+    if (catalog) {
+        nextBookId = std::max(nextBookId, catalog->maxId() + 1);
+    }
+    for (const User& user : users) {
+        nextUserId = std::max(nextUserId, user.getId() + 1);
+    }
+    for (const Book& book : books) {
+        nextBookId = std::max(nextBookId, book.getId() + 1);
+    }
+    nextRecordId = std::max(nextRecordId, borrowRecords.maxRecordId() + 1);
+}
+
+bool LibrarySystem::saveSnapshot() {
+    Snapshot::Writer writer;
+    Snapshot::TableBuilder<User> userTable(writer, "users");
+    for (const User& user : users) {
+        userTable.add(user);
+    }
+    userTable.finish();
+    // 图书按id升序写入，映射目录依赖这一顺序做二分查找
+    Snapshot::TableBuilder<Book> bookTable(writer, "books");
+    // 未被覆盖的映射行按列原样复制，只有常驻（新增或物化过）的图书需要编码
+    forEachBookSource([&bookTable](const Book& book) { bookTable.add(book); },
+                      [&](uint32_t row) { catalog->copyRow(row, bookTable); });
+    bookTable.finish();
+    writer.addTable("records", borrowRecords.active());
+    Snapshot::TableBuilder<HoldQueues::Hold> holdTable(writer, "holds");
+    for (const auto& hold : holds.all()) {
+        holdTable.add(hold);
+    }
+    holdTable.finish();
+    if (!writer.writeToFile(SNAPSHOT_FILE)) {
+        std::cerr << "写入快照失败: " << SNAPSHOT_FILE << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool LibrarySystem::jsonEditedSinceSave() const {
+    std::error_code ec;
+    if (!std::filesystem::exists(EXPORT_MANIFEST_FILE, ec)) {
+        // 没有清单（旧版本的数据目录，或上次快照没写成）：JSON比快照新就采用JSON
+        auto snapshotTime = std::filesystem::last_write_time(SNAPSHOT_FILE, ec);
+        if (ec) {
+            return true;
+        }
+        for (const auto& path : {USERS_FILE, BOOKS_FILE, RECORDS_FILE, HOLDS_FILE}) {
+            auto jsonTime = std::filesystem::last_write_time(path, ec);
+            if (!ec && jsonTime > snapshotTime) {
+                return true;
             }
-            usersFile.close();
         }
-        
-        // 加载图书数据
-        std::ifstream booksFile(BOOKS_FILE);
-        if (booksFile.is_open()) {
-            Json::Value booksJson;
-            booksFile >> booksJson;
-            
-            for (const auto& bookJson : booksJson) {
-                auto book = std::make_unique<Book>();
-                book->fromJson(bookJson);
-                if (book->getId() >= nextBookId) {
-                    nextBookId = book->getId() + 1;
+        return false;
+    }
+    
+    // 空清单表示上次导出没有完成，清单损坏同样以快照为准
+    std::vector<std::unique_ptr<ExportStamp>> stamps;
+    if (!readJsonFile(EXPORT_MANIFEST_FILE, stamps)) {
+        return false;
+    }
+    for (const auto& recorded : stamps) {
+        ExportStamp current;
+        if (stampFile(recorded->file, current) &&
+            (current.modified != recorded->modified || current.size != recorded->size)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LibrarySystem::importJsonData() {
+    // 直接解析到实体，不经过DOM。三个文件全部解析成功才替换内存数据，
+    // 避免用半份数据继续运行并在下次保存时覆盖掉原文件
+    std::vector<std::unique_ptr<User>> loadedUsers;
+    std::vector<std::unique_ptr<Book>> loadedBooks;
+    std::vector<std::unique_ptr<BorrowRecord>> loadedRecords;
+    std::vector<std::unique_ptr<HoldQueues::Hold>> loadedHolds;
+    // 三个文件互不依赖，各自在一个线程上读取和解析
+    auto usersTask = std::async(std::launch::async, [&] { return readJsonFile(USERS_FILE, loadedUsers); });
+    auto booksTask = std::async(std::launch::async, [&] { return readJsonFile(BOOKS_FILE, loadedBooks); });
+    bool recordsOk = readJsonFile(RECORDS_FILE, loadedRecords);
+    // 预约队列损坏不影响其余数据，只丢弃预约
+    if (!readJsonFile(HOLDS_FILE, loadedHolds)) {
+        std::cerr << "预约数据损坏，已忽略: " << HOLDS_FILE << std::endl;
+    }
+    
+    bool ok = true;
+    if (!usersTask.get()) {
+        std::cerr << "用户数据格式错误: " << USERS_FILE << std::endl;
+        ok = false;
+    }
+    if (!booksTask.get()) {
+        std::cerr << "图书数据格式错误: " << BOOKS_FILE << std::endl;
+        ok = false;
+    }
+    if (!recordsOk) {
+        std::cerr << "借阅记录格式错误: " << RECORDS_FILE << std::endl;
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+    
+    replaceEntities(users, userIndex, loadedUsers);
+    replaceEntities(books, bookIndex, loadedBooks);
+    borrowRecords.replaceActive(std::move(loadedRecords));
+    restoreHolds(loadedHolds);
+    updateNextIds();
+    return true;
+}
+
+void LibrarySystem::restoreHolds(const std::vector<std::unique_ptr<HoldQueues::Hold>>& loaded) {
+    std::vector<HoldQueues::Hold> queued;
+    queued.reserve(loaded.size());
+    for (const auto& hold : loaded) {
+        queued.push_back(*hold);
+    }
+    holds.restore(queued);
+}
+
+void LibrarySystem::quarantineDataFiles() {
+    // 没有任何可用数据时，把损坏的文件改名保留下来，防止随后的保存覆盖它们
+    std::string suffix = ".corrupt-" + std::to_string(std::time(nullptr));
+    for (const auto& path : {USERS_FILE, BOOKS_FILE, RECORDS_FILE, SNAPSHOT_FILE, SNAPSHOT_FILE + ".prev"}) {
+        std::error_code ec;
+        if (std::filesystem::exists(path, ec)) {
+            std::filesystem::rename(path, path + suffix, ec);
+            std::cerr << "数据文件无法恢复，已另存为: " << path << suffix << std::endl;
+        }
+    }
+}
+
+BulkTransfer::Report LibrarySystem::importFile(const std::string& kind, const std::string& path,
+                                               const BulkTransfer::ProgressHook& progress) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    BulkTransfer::Report report;
+    if (kind == "users") {
+        report = BulkTransfer::importFile<User>(path, [&](std::unique_ptr<User> user) -> std::string {
+            if (!validateInput(user->getName())) {
+                return "用户名不能为空且不超过255个字符";
+            }
+            if (user->getId() <= 0) {
+                user->setId(nextUserId++);
+            }
+            if (userIndex.count(user->getId())) {
+                return "用户id已存在: " + std::to_string(user->getId());
+            }
+            nextUserId = std::max(nextUserId, user->getId() + 1);
+            // 在借图书只在该书确实有一册借给了这位读者、且有对应的未归还记录时保留，
+            // 否则从在借列表中去掉，不留下没人能还的借阅
+            std::unordered_set<int> loans;
+            User::LoanList listed = user->getActiveLoans();
+            for (int bookId : listed) {
+                Book* book = findBook(bookId);
+                bool onLoan = book && loans.insert(bookId).second && book->isBorrowedBy(user->getId()) &&
+                              borrowRecords.findOpen(user->getId(), bookId) != nullptr;
+                if (!onLoan) {
+                    user->removeBorrowRecord(bookId);
+                }
+            }
+            insertEntity(users, userIndex, std::move(*user));
+            return "";
+        }, progress);
+    } else if (kind == "books") {
+        std::unordered_set<int> ids;
+        forEachBook([&ids](const Book& book) { ids.insert(book.getId()); });
+        report = BulkTransfer::importFile<Book>(path, [&](std::unique_ptr<Book> book) -> std::string {
+            if (!validateInput(book->getName()) || !validateInput(book->getAuthor())) {
+                return "书名和作者不能为空且不超过255个字符";
+            }
+            if (book->getId() <= 0) {
+                book->setId(nextBookId++);
+            }
+            if (!ids.insert(book->getId()).second) {
+                return "图书id已存在: " + std::to_string(book->getId());
+            }
+            nextBookId = std::max(nextBookId, book->getId() + 1);
+            // 借出状态只在读者确实在借这本书时保留，否则该册改回在架，不留下没人借的借出副本
+            std::unordered_set<int> borrowers;
+            SmallVector<int, 2> listed = book->getCopyBorrowers();
+            for (int borrower : listed) {
+                if (borrower == 0) {
+                    continue;
                 }
-                books.push_back(std::move(book));
+                User* user = findUser(borrower);
+                bool onLoan = user && borrowers.insert(borrower).second &&
+                              std::find(user->getActiveLoans().begin(), user->getActiveLoans().end(),
+                                        book->getId()) != user->getActiveLoans().end();
+                if (!onLoan) {
+                    book->returnBook(borrower);
+                }
+            }
+            insertEntity(books, bookIndex, std::move(*book));
+            return "";
+        }, progress);
+    } else if (kind == "records") {
+        // 已关闭段里的id只知道最大值，所以新记录的id必须大于现有的所有记录
+        int maxExisting = borrowRecords.maxRecordId();
+        std::unordered_set<int> ids;
+        // 每笔在借（读者, 图书）只能有一条未归还记录
+        auto loanKey = [](int userId, int bookId) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(userId)) << 32) | static_cast<uint32_t>(bookId);
+        };
+        std::unordered_set<uint64_t> openLoans;
+        for (const auto& record : borrowRecords.active()) {
+            if (!record->getIsReturned()) {
+                openLoans.insert(loanKey(record->getUserId(), record->getBookId()));
             }
-            booksFile.close();
         }
-        
-        // 加载借阅记录
-        std::ifstream recordsFile(RECORDS_FILE);
-        if (recordsFile.is_open()) {
-            Json::Value recordsJson;
-            recordsFile >> recordsJson;
-            
-            for (const auto& recordJson : recordsJson) {
-                auto record = std::make_unique<BorrowRecord>(0, 0, 0);
-                record->fromJson(recordJson);
-                if (record->getRecordId() >= nextRecordId) {
-                    nextRecordId = record->getRecordId() + 1;
+        report = BulkTransfer::importFile<BorrowRecord>(path, [&](std::unique_ptr<BorrowRecord> record) -> std::string {
+            if (record->getRecordId() <= maxExisting || ids.count(record->getRecordId())) {
+                return "记录id缺失或与已有记录冲突: " + std::to_string(record->getRecordId());
+            }
+            if (record->getUserId() <= 0 || record->getBookId() <= 0) {
+                return "缺少userId或bookId";
+            }
+            if (!record->getIsReturned()) {
+                // 未归还的记录必须对应读者和图书上已有的在借状态，否则会生成没人能还的借阅
+                User* user = findUser(record->getUserId());
+                Book* book = findBook(record->getBookId());
+                if (!user || !book || !book->isBorrowedBy(user->getId()) ||
+                    std::find(user->getActiveLoans().begin(), user->getActiveLoans().end(), book->getId()) ==
+                        user->getActiveLoans().end()) {
+                    return "未归还记录与读者和图书的在借状态不符: " + std::to_string(record->getRecordId());
+                }
+                if (!openLoans.insert(loanKey(user->getId(), book->getId())).second) {
+                    return "该笔借阅已有未归还记录: " + std::to_string(record->getRecordId());
                 }
-                borrowRecords.push_back(std::move(record));
             }
-            recordsFile.close();
+            ids.insert(record->getRecordId());
+            borrowRecords.add(std::move(record));
+            return "";
+        }, progress);
+        if (report.succeeded > 0) {
+            updateStatistics();
+            rebuildDueDates();
         }
-        
-        updateStatistics();
-        
-    } catch (const std::exception& e) {
-        std::cerr << "加载数据失败: " << e.what() << std::endl;
+    } else {
+        report.fatal = "未知的数据类型: " + kind;
+    }
+    
+    if (report.succeeded > 0) {
+        updateNextIds();
+        saveData();
+    }
+    return report;
+}
+
+BulkTransfer::Report LibrarySystem::exportFile(const std::string& kind, const std::string& path,
+                                               const BulkTransfer::ProgressHook& progress) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    BulkTransfer::Report report;
+    auto run = [&](auto& exporter, auto&& visit) {
+        if (!exporter.isOpen()) {
+            report.fatal = "无法写入文件: " + path;
+            return;
+        }
+        visit();
+        report.succeeded = exporter.records();
+        if (!exporter.finish()) {
+            report.fatal = "写入文件失败: " + path;
+        }
+    };
+    if (kind == "users") {
+        BulkTransfer::Exporter<User> exporter(path, users.size(), progress);
+        run(exporter, [&] {
+            for (const User& user : users) {
+                exporter.add(user);
+            }
+        });
+    } else if (kind == "books") {
+        BulkTransfer::Exporter<Book> exporter(path, getBookCount(), progress);
+        run(exporter, [&] { forEachBook([&exporter](const Book& book) { exporter.add(book); }); });
+    } else if (kind == "records") {
+        BulkTransfer::Exporter<BorrowRecord> exporter(path, borrowRecords.size(), progress);
+        run(exporter, [&] { borrowRecords.forEach([&exporter](const BorrowRecord& record) { exporter.add(record); }); });
+    } else {
+        report.fatal = "未知的数据类型: " + kind;
     }
+    return report;
 }
 
 void LibrarySystem::loadTestData() {
     // 如果没有数据，加载测试数据
-    if (users.empty() && books.empty()) {
+    if (users.empty() && getBookCount() == 0) {
         // 添加测试用户
         addUser("张三", "zhangsan@example.com", "13800138001");
         addUser("李四", "lisi@example.com", "13800138002");
@@ -685,10 +1927,107 @@ std::string LibrarySystem::getCurrentTimeString() {
 }
 
 void LibrarySystem::updateStatistics() {
+    // 以段为单位分给多个线程（活动段也算一段），各自累计到局部统计，最后合并
+    std::vector<int> months = borrowRecords.closedMonths();
+    size_t segments = months.size() + 1;
+    size_t threads = std::clamp<size_t>(borrowRecords.size() / MIN_RECORDS_PER_THREAD, 1,
+                                        std::min<size_t>(segments, hardwareThreads()));
+    std::vector<Statistics> partials(threads);
+    
+    // 分类去重计数按借阅时图书所属的分类归类；已删除图书的记录不计入分类。
+    // 映射目录只读取分类一列，不解码整行，启动时不必把整个目录过一遍
+    std::vector<Symbol> rowCategories;
+    if (catalog) {
+        rowCategories.resize(catalog->size());
+        std::unordered_map<std::string_view, Symbol> interned;
+        for (uint32_t row = 0; row < catalog->size(); ++row) {
+            std::string_view text = catalog->categoryAt(row);
+            auto it = interned.find(text);
+            if (it == interned.end()) {
+                it = interned.emplace(text, Symbol(text)).first;
+            }
+            rowCategories[row] = it->second;
+        }
+    }
+    static const std::string noCategory;
+    auto categoryOf = [&](int bookId) -> const std::string& {
+        if (const Book* book = findEntity(books, bookIndex, bookId)) {
+            return book->getCategory();
+        }
+        if (catalog && !catalogOverrides.count(bookId)) {
+            if (auto row = catalog->findRow(bookId)) {
+                return rowCategories[*row].str();
+            }
+        }
+        return noCategory;
+    };
+    
+    // 早于8个半衰期的借阅权重不到1/256，不再计入热门趋势
+    std::time_t trendingSince = std::time(nullptr) - 8 * Statistics::TRENDING_HALF_LIFE;
+    
+    auto accumulate = [&](size_t worker) {
+        Statistics& partial = partials[worker];
+        auto count = [&](const BorrowRecord& record) {
+            partial.updateBookPopularity(record.getBookId());
+            partial.updateUserActivity(record.getUserId());
+            partial.updateUserBorrows(record.getUserId());
+            partial.updateMonthlyStats(record.getBorrowTime());
+            partial.updateBorrowSeries(record.getBorrowTime());
+            partial.updateHeatmap(record.getBorrowTime());
+            partial.updateDistinctCounts(record.getUserId(), record.getBookId(), categoryOf(record.getBookId()));
+            if (record.getBorrowTime() >= trendingSince) {
+                partial.updateTrending(record.getBookId(), categoryOf(record.getBookId()), record.getBorrowTime());
+            }
+            if (record.getIsReturned()) {
+                partial.updateReturnSeries(record.getReturnTime());
+                partial.updateUserReturns(record.getUserId(), record.getBorrowTime(), record.getReturnTime(),
+                                          record.getDueTime());
+            }
+        };
+        for (size_t segment = worker; segment < segments; segment += threads) {
+            if (segment < months.size()) {
+                // 已关闭段直接在解码后的平行数组上循环
+                borrowRecords.scanSegment(months[segment], [&](const RecordArchive::Columns& columns) {
+                    for (size_t i = 0; i < columns.size(); ++i) {
+                        partial.updateBookPopularity(columns.bookIds[i]);
+                        partial.updateUserActivity(columns.userIds[i]);
+                        partial.updateMonthlyStats(columns.borrowTimes[i]);
+                        partial.updateBorrowSeries(columns.borrowTimes[i]);
+                        partial.updateHeatmap(columns.borrowTimes[i]);
+                        partial.updateReturnSeries(columns.returnTimes[i]);
+                        // 已关闭段的记录都已归还；旧记录没有应还时间，按默认借期推算
+                        partial.updateUserBorrows(columns.userIds[i]);
+                        std::time_t dueTime = columns.dueTimes[i] != 0
+                                                  ? columns.dueTimes[i]
+                                                  : columns.borrowTimes[i] + BorrowRecord::DEFAULT_LOAN_PERIOD;
+                        partial.updateUserReturns(columns.userIds[i], columns.borrowTimes[i], columns.returnTimes[i],
+                                                  dueTime);
+                        partial.updateDistinctCounts(columns.userIds[i], columns.bookIds[i],
+                                                     categoryOf(columns.bookIds[i]));
+                        if (columns.borrowTimes[i] >= trendingSince) {
+                            partial.updateTrending(columns.bookIds[i], categoryOf(columns.bookIds[i]),
+                                                   columns.borrowTimes[i]);
+                        }
+                    }
+                });
+            } else {
+                for (const auto& record : borrowRecords.active()) {
+                    count(*record);
+                }
+            }
+        }
+    };
+    std::vector<std::future<void>> tasks;
+    for (size_t worker = 1; worker < threads; ++worker) {
+        tasks.push_back(std::async(std::launch::async, accumulate, worker));
+    }
+    accumulate(0);
+    for (auto& task : tasks) {
+        task.get();
+    }
+    
     statistics.clear();
-    for (const auto& record : borrowRecords) {
-        statistics.updateBookPopularity(record->getBookId());
-        statistics.updateUserActivity(record->getUserId());
-        statistics.updateMonthlyStats(record->getBorrowTime());
+    for (const auto& partial : partials) {
+        statistics.merge(partial);
     }
 }
\ No newline at end of file
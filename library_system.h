@@ -11,7 +11,24 @@
 #include <ctime>
 #include <iomanip>
 #include <memory>
+#include <unordered_set>
+#include <unordered_map>
+#include <mutex>
+#include <span>
 #include "json.h"
+#include "json_codec.h"
+#include "mapped_catalog.h"
+#include "record_store.h"
+#include "top_k.h"
+#include "rolling_counter.h"
+#include "hyper_log_log.h"
+#include "trending_sketch.h"
+#include "due_scheduler.h"
+#include "hold_queue.h"
+#include "copy_set.h"
+#include "bulk_transfer.h"
+#include "slot_map.h"
+#include "small_vector.h"
 
 // 抽象基类 - 实体基类
 class Entity {
@@ -25,6 +42,11 @@ public:
         : id(id), name(name), createTime(std::time(nullptr)) {}
     
     virtual ~Entity() = default;
+    // 实体按值存放在实体池中，需要可移动
+    Entity(const Entity&) = default;
+    Entity(Entity&&) = default;
+    Entity& operator=(const Entity&) = default;
+    Entity& operator=(Entity&&) = default;
     
     // 纯虚函数
     virtual std::string toString() const = 0;
@@ -50,9 +72,15 @@ class User : public Entity {
 private:
     std::string email;
     std::string phone;
-    std::vector<int> borrowHistory;
     int maxBorrowCount;
     
+public:
+    // 在借图书的id。借阅上限默认为5，6个内联槽位正好与堆指针共用空间，一般不做堆分配
+    using LoanList = SmallVector<int, 6>;
+    
+private:
+    LoanList activeLoans;
+    
 public:
     User(int id = 0, const std::string& name = "", const std::string& email = "", 
          const std::string& phone = "", int maxBorrow = 5)
@@ -64,16 +92,30 @@ public:
     void fromJson(const Json::Value& json) override;
     void display() const override;
     
+    // 字段描述表：供 Json::writeObject/readObject 直接读写JSON，无需中间DOM
+    static constexpr auto jsonFields() {
+        return std::make_tuple(
+            Json::field("id", &User::id),
+            Json::field("name", &User::name),
+            Json::field("email", &User::email),
+            Json::field("phone", &User::phone),
+            Json::field("maxBorrowCount", &User::maxBorrowCount),
+            Json::field("createTime", &User::createTime),
+            Json::field("borrowHistory", &User::activeLoans)); // 键名沿用旧数据
+    }
+    
     // 用户特有方法
     void addBorrowRecord(int bookId);
     void removeBorrowRecord(int bookId);
-    bool canBorrow() const;
+    // 再借count本是否超出借阅上限
+    bool canBorrow(int count = 1) const;
     int getCurrentBorrowCount() const;
     
     // 访问器
     std::string getEmail() const { return email; }
     std::string getPhone() const { return phone; }
-    const std::vector<int>& getBorrowHistory() const { return borrowHistory; }
+    // 借阅历史见 LibrarySystem::getUserBorrowHistory
+    const LoanList& getActiveLoans() const { return activeLoans; }
     int getMaxBorrowCount() const { return maxBorrowCount; }
     
     void setEmail(const std::string& newEmail) { email = newEmail; }
@@ -81,24 +123,31 @@ public:
     void setMaxBorrowCount(int count) { maxBorrowCount = count; }
 };
 
-// 图书类
+// 图书类：一个书目，可以有多册副本
 class Book : public Entity {
 private:
-    std::string author;
-    std::string category;
+    Symbol author;     // 作者和分类重复度高，驻留后每本书只存一个指针
+    Symbol category;
     std::string keywords;
     std::string description;
-    bool isAvailable;
-    int borrowerId;
-    std::vector<int> borrowHistory;
+    bool isAvailable;  // 是否还有在架的副本
+    int borrowerId;    // 只有一册时为其借阅者，否则为0；保留给旧数据和旧客户端
+    // 借阅历史不放在图书上（会无限增长），由借阅记录的按书索引提供，见 LibrarySystem::getBookBorrowHistory
+    SmallVector<int, 2> copyBorrowers; // 每册的借阅者，0表示在架；多数书目只有一两册，不做堆分配
+    CopySet shelf;                     // 由copyBorrowers重建，不持久化
+    
+    void rebuildShelf();
+    void syncAvailability();
     
 public:
     Book(int id = 0, const std::string& title = "", const std::string& author = "",
          const std::string& category = "", const std::string& keywords = "",
-         const std::string& description = "")
+         const std::string& description = "", int copies = 1)
         : Entity(id, title), author(author), category(category), 
           keywords(keywords), description(description), 
-          isAvailable(true), borrowerId(0) {}
+          isAvailable(true), borrowerId(0), copyBorrowers(std::max(copies, 1), 0) {
+        shelf.reset(copyBorrowers.size());
+    }
     
     // 重写虚函数
     std::string toString() const override;
@@ -106,23 +155,52 @@ public:
     void fromJson(const Json::Value& json) override;
     void display() const override;
     
+    // 字段描述表：供 Json::writeObject/readObject 直接读写JSON，无需中间DOM
+    static constexpr auto jsonFields() {
+        return std::make_tuple(
+            Json::field("id", &Book::id),
+            Json::field("title", &Book::name),
+            Json::field("author", &Book::author),
+            Json::field("category", &Book::category),
+            Json::field("keywords", &Book::keywords),
+            Json::field("description", &Book::description),
+            Json::field("isAvailable", &Book::isAvailable),
+            Json::field("borrowerId", &Book::borrowerId),
+            Json::field("createTime", &Book::createTime),
+            Json::field("copyBorrowers", &Book::copyBorrowers));
+    }
+    
+    // 读取持久化字段后重建在架位图。只有一册时以isAvailable/borrowerId为准，兼容没有copyBorrowers的旧数据
+    void afterRead();
+    
     // 图书特有方法
-    void borrowBook(int userId);
-    void returnBook();
+    // 借出编号最小的在架副本，O(1)；返回副本编号，没有在架副本时返回-1
+    int borrowBook(int userId);
+    // 归还该读者借走的那一册
+    bool returnBook(int userId);
     bool matchesKeyword(const std::string& keyword) const;
-    void addBorrowHistory(int userId);
+    
+    // 副本管理：减少副本时只能去掉在架的副本
+    static constexpr int MAX_COPIES = static_cast<int>(CopySet::MAX_COPIES);
+    bool setCopyCount(int copies);
+    int getCopyCount() const { return static_cast<int>(copyBorrowers.size()); }
+    int getAvailableCopyCount() const { return static_cast<int>(shelf.freeCount()); }
+    int getBorrowedCopyCount() const { return getCopyCount() - getAvailableCopyCount(); }
+    bool isBorrowedBy(int userId) const;
     
     // 访问器
-    std::string getAuthor() const { return author; }
-    std::string getCategory() const { return category; }
+    const std::string& getAuthor() const { return author.str(); }
+    const std::string& getCategory() const { return category.str(); }
+    Symbol getAuthorSymbol() const { return author; }
+    Symbol getCategorySymbol() const { return category; }
     std::string getKeywords() const { return keywords; }
     std::string getDescription() const { return description; }
     bool getIsAvailable() const { return isAvailable; }
     int getBorrowerId() const { return borrowerId; }
-    const std::vector<int>& getBorrowHistory() const { return borrowHistory; }
+    const SmallVector<int, 2>& getCopyBorrowers() const { return copyBorrowers; }
     
-    void setAuthor(const std::string& newAuthor) { author = newAuthor; }
-    void setCategory(const std::string& newCategory) { category = newCategory; }
+    void setAuthor(const std::string& newAuthor) { author = Symbol(newAuthor); }
+    void setCategory(const std::string& newCategory) { category = Symbol(newCategory); }
     void setKeywords(const std::string& newKeywords) { keywords = newKeywords; }
     void setDescription(const std::string& newDesc) { description = newDesc; }
 };
@@ -136,17 +214,40 @@ private:
     std::time_t borrowTime;
     std::time_t returnTime;
     bool isReturned;
+    std::time_t dueTime; // 0表示旧数据没有记录应还时间，按默认借期推算
+    bool reminded;       // 已发出到期提醒，重启后不再重复提醒
     
 public:
-    BorrowRecord(int id, int userId, int bookId)
+    // 默认借期30天
+    static constexpr std::time_t DEFAULT_LOAN_PERIOD = 30 * 24 * 3600;
+    
+    BorrowRecord(int id = 0, int userId = 0, int bookId = 0)
         : recordId(id), userId(userId), bookId(bookId), 
-          borrowTime(std::time(nullptr)), returnTime(0), isReturned(false) {}
+          borrowTime(std::time(nullptr)), returnTime(0), isReturned(false), dueTime(0), reminded(false) {}
+    BorrowRecord(int id, int userId, int bookId, std::time_t borrowTime, std::time_t returnTime, bool isReturned,
+                 std::time_t dueTime = 0)
+        : recordId(id), userId(userId), bookId(bookId),
+          borrowTime(borrowTime), returnTime(returnTime), isReturned(isReturned), dueTime(dueTime), reminded(false) {}
     
     void returnBook();
+    void markReminded() { reminded = true; }
     Json::Value toJson() const;
     void fromJson(const Json::Value& json);
     std::string toString() const;
     
+    // 字段描述表：供 Json::writeObject/readObject 直接读写JSON，无需中间DOM
+    static constexpr auto jsonFields() {
+        return std::make_tuple(
+            Json::field("recordId", &BorrowRecord::recordId),
+            Json::field("userId", &BorrowRecord::userId),
+            Json::field("bookId", &BorrowRecord::bookId),
+            Json::field("borrowTime", &BorrowRecord::borrowTime),
+            Json::field("returnTime", &BorrowRecord::returnTime),
+            Json::field("isReturned", &BorrowRecord::isReturned),
+            Json::field("dueTime", &BorrowRecord::dueTime),
+            Json::field("reminded", &BorrowRecord::reminded));
+    }
+    
     // 访问器
     int getRecordId() const { return recordId; }
     int getUserId() const { return userId; }
@@ -154,6 +255,9 @@ public:
     std::time_t getBorrowTime() const { return borrowTime; }
     std::time_t getReturnTime() const { return returnTime; }
     bool getIsReturned() const { return isReturned; }
+    bool wasReminded() const { return reminded; }
+    std::time_t getDueTime() const { return dueTime != 0 ? dueTime : borrowTime + DEFAULT_LOAN_PERIOD; }
+    bool isOverdue(std::time_t now) const { return (isReturned ? returnTime : now) > getDueTime(); }
 };
 
 // 统计分析类 - 多重继承示例
@@ -170,20 +274,96 @@ public:
 };
 
 class Statistics : public Displayable, public Serializable {
+public:
+    // 增量维护的排行榜长度；serialize只输出排行榜，不随图书和用户数量增长
+    static constexpr size_t TOP_K = 10;
+    // 每本书/每个用户的草图最多1KB（相对标准误差约3.3%），分类数量少，用16KB换约0.8%的误差
+    static constexpr unsigned BOOK_SKETCH_PRECISION = 10;
+    static constexpr unsigned CATEGORY_SKETCH_PRECISION = 14;
+    // 热门趋势：每个分类（及全馆）保留的计数器数量和得分半衰期
+    static constexpr size_t TRENDING_CAPACITY = 64;
+    static constexpr int64_t TRENDING_HALF_LIFE = 7 * 24 * 3600;
+    
+    // 单个读者的借阅计数（精确值，含已归档的月份）
+    struct UserLoanCounts {
+        int borrows = 0;
+        int returns = 0;
+        int64_t loanDays = 0; // 已归还借阅的天数合计，每笔不足一天按一天计
+        int lateReturns = 0;
+    };
+
 private:
-    std::map<int, int> bookPopularity;  // 图书ID -> 借阅次数
-    std::map<int, int> userActivity;    // 用户ID -> 借阅次数
-    std::map<std::string, int> monthlyStats; // 月份 -> 借阅次数
+    TopKCounter bookPopularity{TOP_K};  // 图书ID -> 借阅次数
+    TopKCounter userActivity{TOP_K};    // 用户ID -> 借阅次数
+    std::map<int, int> monthlyStats; // 月份键(年*100+月) -> 借阅次数，输出时才格式化为"YYYY-MM"
+    
+    // 滚动借还次数（按本地时间对齐）：最近14天的小时桶、最近一年的日桶、最近两年的周桶
+    RollingCounter hourlySeries;
+    RollingCounter dailySeries;
+    RollingCounter weeklySeries;
+    
+    // 去重计数（HyperLogLog，误差见 *_ERROR）：每本书的不同读者、每个用户借过的不同图书、每个分类的不同读者
+    std::unordered_map<int, HyperLogLog<BOOK_SKETCH_PRECISION>> bookReaders;
+    std::unordered_map<int, HyperLogLog<BOOK_SKETCH_PRECISION>> userBooks;
+    std::map<std::string, HyperLogLog<CATEGORY_SKETCH_PRECISION>> categoryReaders;
+    
+    // 每个读者的借阅计数，读者页面的借阅统计直接从这里读取
+    std::unordered_map<int, UserLoanCounts> userLoans;
+    
+    // 借阅热力图：年份 -> 一年中第几天(0~365)×24小时 的借阅次数，按本地时间归类
+    static constexpr size_t HEATMAP_CELLS = 366 * 24;
+    std::map<int, std::vector<int>> borrowHeatmap;
+    
+    // 最近的热门图书（指数衰减的Space-Saving）：全馆一份，每个分类一份
+    std::time_t trendingLandmark;
+    TrendingSketch trending;
+    std::map<std::string, TrendingSketch> categoryTrending;
+    
+    TrendingSketch& trendingFor(const std::string& category);
     
 public:
+    Statistics();
+    
     void updateBookPopularity(int bookId);
     void updateUserActivity(int userId);
     void updateMonthlyStats(std::time_t borrowTime);
-    
+    void updateBorrowSeries(std::time_t borrowTime);
+    void updateReturnSeries(std::time_t returnTime);
+    // category为空（图书已删除）时只更新图书和用户的草图
+    void updateDistinctCounts(int userId, int bookId, const std::string& category);
+    void updateTrending(int bookId, const std::string& category, std::time_t borrowTime);
+    void updateHeatmap(std::time_t borrowTime);
+    void updateUserBorrows(int userId);
+    void updateUserReturns(int userId, std::time_t borrowTime, std::time_t returnTime, std::time_t dueTime);
+    
+    // 把另一份（通常是某个线程的局部）统计累加进来
+    void merge(const Statistics& other);
+    
+    // count不超过TOP_K时是O(count)
     std::vector<std::pair<int, int>> getMostPopularBooks(int count = 10) const;
     std::vector<std::pair<int, int>> getMostActiveUsers(int count = 10) const;
     std::map<std::string, int> getMonthlyTrends() const;
     
+    // 去重计数的估计值，没有借阅记录时为0
+    double estimateBookReaders(int bookId) const;
+    double estimateUserBooks(int userId) const;
+    double estimateCategoryReaders(const std::string& category) const;
+    
+    // 没有借阅记录的读者返回全0
+    UserLoanCounts getUserLoanCounts(int userId) const;
+    
+    // 某一年的热力图：只输出有借阅的日期，每天附24小时的分布
+    Json::Value serializeHeatmap(int year) const;
+    
+    // category为空时返回全馆的热门图书；未知分类返回空列表
+    std::vector<TrendingSketch::Entry> getTrendingBooks(const std::string& category, size_t count, std::time_t now) const;
+    // category为空时输出全馆及每个分类的前count名
+    Json::Value serializeTrending(const std::string& category, size_t count, std::time_t now) const;
+    
+    // granularity为"hour"/"day"/"week"，其他值返回nullptr
+    const RollingCounter* getTimeSeries(const std::string& granularity) const;
+    Json::Value serializeTimeSeries(const std::string& granularity, size_t buckets, std::time_t now) const;
+    
     // 实现抽象方法
     void showStatistics() const override;
     Json::Value serialize() const override;
@@ -194,11 +374,19 @@ public:
 // 主要的图书管理系统类
 class LibrarySystem {
 private:
-    std::vector<std::unique_ptr<User>> users;
-    std::vector<std::unique_ptr<Book>> books;
-    std::vector<std::unique_ptr<BorrowRecord>> borrowRecords;
+    // 用户和图书按块连续存放在实体池中；id索引保存句柄，实体被删除后旧句柄自动失效
+    SlotMap<User> users;
+    SlotMap<Book> books;
+    std::unordered_map<int, SlotMap<User>::Handle> userIndex;
+    std::unordered_map<int, SlotMap<Book>::Handle> bookIndex;
     Statistics statistics;
     
+    // 延迟目录模式：图书留在映射的快照中，只有被访问的图书才物化到books。
+    // catalogOverrides记录已物化或已删除的快照图书id，遍历时跳过其映射行
+    bool lazyCatalog;
+    std::unique_ptr<MappedCatalog> catalog;
+    std::unordered_set<int> catalogOverrides;
+    
     int nextUserId;
     int nextBookId;
     int nextRecordId;
@@ -207,9 +395,72 @@ private:
     const std::string USERS_FILE = "data/users.json";
     const std::string BOOKS_FILE = "data/books.json";
     const std::string RECORDS_FILE = "data/records.json";
+    const std::string SNAPSHOT_FILE = "data/library.snap";
+    // 记录上次完整导出后各JSON文件的修改时间和大小，用来区分手动修改和写了一半的导出
+    const std::string EXPORT_MANIFEST_FILE = "data/exports.manifest";
+    const std::string RECORD_SEGMENTS_DIR = "data/records";
+    
+    // 借阅记录按月分段：records.json和快照中只保存活动段
+    RecordStore borrowRecords;
+    
+    // 未归还借阅按应还时间排期，逾期集合随时可查
+    DueScheduler dueDates;
+    DueScheduler::Hook dueSoonHook;
+    // 已发出提醒、还没写回借阅记录的记录ID；保存或重建排期前统一标记
+    std::unordered_set<int> unsavedReminders;
+    // 有待取书预约过期、尚未保存
+    bool unsavedHoldExpiry = false;
+    
+    // 每本书的预约队列；归还时自动留给队首读者
+    HoldQueues holds;
+    const std::string HOLDS_FILE = "data/holds.json";
+    
+    // 增删改、借还、预约和保存互斥，保证并发请求下图书、借阅记录和预约队列一致。
+    // 查找和遍历同样加锁：延迟目录模式下查找会物化图书，改动实体池和索引。
+    // find*/get*返回的指针仍由调用方自行保证不与删除操作并发使用
+    mutable std::recursive_mutex mutex;
     
 public:
-    LibrarySystem();
+    // 应还前多久触发到期提醒
+    static constexpr std::time_t DUE_NOTICE_PERIOD = 3 * 24 * 3600;
+    // 预约的书留出后，读者须在此期限内借走
+    static constexpr std::time_t HOLD_PICKUP_WINDOW = 3 * 24 * 3600;
+    
+    // 批量添加图书的一项输入
+    struct BookInput {
+        std::string title;
+        std::string author;
+        std::string category;
+        std::string keywords;
+        std::string description;
+        int copies = 1;
+        
+        static constexpr auto jsonFields() {
+            return std::make_tuple(
+                Json::field("title", &BookInput::title),
+                Json::field("author", &BookInput::author),
+                Json::field("category", &BookInput::category),
+                Json::field("keywords", &BookInput::keywords),
+                Json::field("description", &BookInput::description),
+                Json::field("copies", &BookInput::copies));
+        }
+    };
+    
+    // 批量操作中一项的结果：成功时id为新建或受影响的实体id，失败时为-1并给出原因
+    struct ItemResult {
+        int id;
+        std::string error;
+        
+        bool ok() const { return id > 0; }
+    };
+    
+    // 分面统计中的一项：某个分类或作者下的图书数
+    struct FacetCount {
+        std::string value;
+        int count;
+    };
+    
+    explicit LibrarySystem(bool lazyCatalog = false);
     ~LibrarySystem();
     
     // 用户管理
@@ -220,34 +471,86 @@ public:
     std::vector<User*> searchUsers(const std::string& keyword);
     std::vector<User*> getAllUsers();
     
-    // 图书管理
+    // 图书管理：一个书目可以有多册副本（最多Book::MAX_COPIES册）
     int addBook(const std::string& title, const std::string& author, 
                 const std::string& category, const std::string& keywords, 
-                const std::string& description);
+                const std::string& description, int copies = 1);
+    // 批量添加：逐项校验并分配id，失败的项不影响其他项；整批只保存一次。结果与输入一一对应
+    std::vector<ItemResult> addBooks(std::span<const BookInput> inputs);
     bool deleteBook(int bookId);
+    // copies为0时不改副本数；不能少于已借出和留给待取书读者的册数
     bool updateBook(int bookId, const std::string& title, const std::string& author,
                    const std::string& category, const std::string& keywords,
-                   const std::string& description);
+                   const std::string& description, int copies = 0);
     Book* findBook(int bookId);
     std::vector<Book*> searchBooks(const std::string& keyword);
     std::vector<Book*> getAllBooks();
+    size_t getBookCount() const;
+    // 按"category"或"author"统计图书数，按数量降序；在符号id上计数，不比较字符串。其他field返回空列表
+    std::vector<FacetCount> getBookFacets(const std::string& field);
+    
+    // 按id顺序访问全部图书；延迟目录模式下映射行被临时解码，不会物化。遍历期间持有锁
+    template <typename Visitor>
+    void forEachBook(Visitor&& visitor) const;
     
-    // 借还书管理
+    // 借还书管理：借阅时分配任意一册在架副本，同一书目每位读者只借一册
     bool borrowBook(int userId, int bookId);
     bool returnBook(int userId, int bookId);
-    std::vector<BorrowRecord*> getUserBorrowHistory(int userId);
-    std::vector<BorrowRecord*> getBookBorrowHistory(int bookId);
-    std::vector<BorrowRecord*> getAllBorrowRecords();
-    
-    // 统计分析
-    Statistics& getStatistics() { return statistics; }
+    // 柜台批量借还：一位读者一次借或还多本书，整批要么全部执行要么都不执行。
+    // 先校验整批（借阅上限按借完后的总数计算），任何一项不通过时不做改动，未通过的项给出原因；
+    // 全部通过时依次执行并只保存一次。结果与输入一一对应，成功时id为图书id
+    std::vector<ItemResult> borrowBooks(int userId, std::span<const int> bookIds);
+    std::vector<ItemResult> returnBooks(int userId, std::span<const int> bookIds);
+    // 已归档的记录以列式存储，历史查询按值返回记录副本
+    std::vector<BorrowRecord> getUserBorrowHistory(int userId);
+    std::vector<BorrowRecord> getBookBorrowHistory(int bookId);
+    std::vector<BorrowRecord> getAllBorrowRecords();
+    size_t getBorrowRecordCount() const;
+    // 读者页面用：读者的全部借阅记录（每条附书名bookTitle）和借阅计数；读者不存在时返回null
+    Json::Value getUserRecordsJson(int userId);
+    Json::Value getUserLoanStatsJson(int userId);
+    
+    // 预约：只能预约没有可借副本（都已借出或留给他人）的图书，返回排队位置（从1开始），失败返回0
+    int placeHold(int userId, int bookId);
+    bool cancelHold(int userId, int bookId);
+    // 按排队顺序返回；查询前先处理过期的待取书预约
+    std::vector<HoldQueues::Hold> getBookHolds(int bookId);
+    std::vector<HoldQueues::Hold> getUserHolds(int userId);
+    
+    // 到期管理：查询前先把调度器推进到当前时间，按应还时间升序返回
+    std::vector<DueScheduler::Loan> getOverdueLoans();
+    std::vector<DueScheduler::Loan> getDueSoonLoans();
+    // 推进到当前时间，触发到期提醒并处理过期的待取书预约；代价只与本次到期的借阅和预约数有关。
+    // HTTP服务器每分钟调用一次；有新提醒或预约过期时保存，已提醒标记随借阅记录持久化
+    void pollDueDates();
+    // 替换到期提醒钩子（默认输出到控制台）。每笔借阅只提醒一次，已提醒的标记随借阅记录保存
+    void setDueSoonHook(DueScheduler::Hook hook);
+    
+    // 统计分析。借还会在其他线程上更新统计，以下接口都在锁内序列化好再返回，不暴露统计对象本身
     Json::Value getStatisticsJson();
-    
-    // 数据持久化
+    // 最近的热门图书，见 Statistics::serializeTrending
+    Json::Value getTrendingJson(const std::string& category, size_t limit);
+    // 最近buckets个桶的借还次数，buckets不超过序列容量；granularity不是hour/day/week时返回null
+    Json::Value getTimeSeriesJson(const std::string& granularity, size_t buckets);
+    // 某一年按日的借阅热力图，见 Statistics::serializeHeatmap
+    Json::Value getHeatmapJson(int year);
+    
+    // 数据持久化：先写快照，再导出全部JSON文件（包括books.json，延迟目录模式下逐块写出，
+    // 不在内存中拼出整个文件），JSON回退加载时各文件总是同一时刻的数据
     void saveData();
     void loadData();
     void loadTestData();
     
+    // 流式批量导入/导出（NDJSON或CSV，按扩展名判断），kind为"users"、"books"或"records"。
+    // 导入保留文件中的id（用户和图书没有id时分配新id），与现有数据冲突的条目计为失败。
+    // 读者的在借图书只在图书有一册借给该读者且有未归还记录时保留，否则从在借列表中去掉；
+    // 图书的借出副本只在对应读者确实在借时保留，否则改回在架；未归还的借阅记录必须与读者和图书的
+    // 在借状态一致，否则计为失败。整个文件导入完后才重建统计并保存一次
+    BulkTransfer::Report importFile(const std::string& kind, const std::string& path,
+                                    const BulkTransfer::ProgressHook& progress = {});
+    BulkTransfer::Report exportFile(const std::string& kind, const std::string& path,
+                                    const BulkTransfer::ProgressHook& progress = {});
+    
     // 工具方法
     bool validateInput(const std::string& input);
     std::string getCurrentTimeString();
@@ -255,6 +558,71 @@ public:
 private:
     void createDataDirectory();
     void updateStatistics();
+    void rebuildDueDates();
+    void markReminders();
+    // 把没留给别人的在架副本依次留给排队等待的读者
+    void handOffHold(int bookId, std::time_t now);
+    // 处理过期的待取书预约，空出的副本交给后面的等待者；有变化时记为未保存，由调用方保存
+    void expireHolds(std::time_t now);
+    // 单本借还的执行部分：调用方已持锁并完成校验，这里只改状态和统计，不保存
+    void applyBorrow(User& user, Book& book, std::time_t now);
+    void applyReturn(User& user, Book& book, std::time_t now);
+    
+    // 二进制快照是主存储格式，JSON文件作为导入/导出格式
+    bool loadSnapshot(const std::string& path);
+    bool saveSnapshot();
+    bool importJsonData();
+    bool jsonEditedSinceSave() const;
+    bool writeJsonExports();
+    void restoreHolds(const std::vector<std::unique_ptr<HoldQueues::Hold>>& loaded);
+    void quarantineDataFiles();
+    void updateNextIds();
+    Book* materializeBook(int bookId);
+    // 按id顺序遍历：常驻图书交给onResident，未被覆盖的映射行号交给onRow。调用方须持锁
+    template <typename ResidentVisitor, typename RowVisitor>
+    void forEachBookSource(ResidentVisitor&& onResident, RowVisitor&& onRow) const;
 };
 
+template <typename Visitor>
+void LibrarySystem::forEachBook(Visitor&& visitor) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    Book scratch;
+    forEachBookSource(visitor, [&](uint32_t row) {
+        catalog->decode(row, scratch);
+        visitor(static_cast<const Book&>(scratch));
+    });
+}
+
+template <typename ResidentVisitor, typename RowVisitor>
+void LibrarySystem::forEachBookSource(ResidentVisitor&& onResident, RowVisitor&& onRow) const {
+    std::vector<const Book*> resident;
+    resident.reserve(books.size());
+    for (const Book& book : books) {
+        resident.push_back(&book);
+    }
+    std::sort(resident.begin(), resident.end(),
+              [](const Book* a, const Book* b) { return a->getId() < b->getId(); });
+    if (!catalog) {
+        for (const Book* book : resident) {
+            onResident(*book);
+        }
+        return;
+    }
+    
+    // 归并两个按id有序的序列：映射行与已物化的图书
+    auto next = resident.begin();
+    for (uint32_t row = 0; row < catalog->size(); ++row) {
+        int id = catalog->idAt(row);
+        for (; next != resident.end() && (*next)->getId() < id; ++next) {
+            onResident(**next);
+        }
+        if (!catalogOverrides.count(id)) {
+            onRow(row);
+        }
+    }
+    for (; next != resident.end(); ++next) {
+        onResident(**next);
+    }
+}
+
 #endif // LIBRARY_SYSTEM_H
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef LOCAL_TIME_H
+#define LOCAL_TIME_H
+
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+// 本地时间的算术换算：启动时取一次时区偏移并缓存，之后把时间戳换算成
+// 年月不再调用localtime（非线程安全且在重建统计时是热点）。
+// 偏移在进程生命周期内不变，夏令时切换前后一小时内的记录可能落到相邻的月份。
+namespace LocalTime {
+
+constexpr int64_t DAY_SECONDS = 24 * 3600;
+
+inline std::tm toLocalTime(std::time_t time) {
+    // localtime返回共享的静态缓冲区，多线程统计时必须使用可重入版本
+    std::tm result{};
+#ifdef _WIN32
+    localtime_s(&result, &time);
+#else
+    localtime_r(&time, &result);
+#endif
+    return result;
+}
+
+// 公历日期 -> 距1970-01-01的天数（month为1~12）
+inline int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2 ? 1 : 0;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+struct CivilDate {
+    int year;
+    int month;  // 1~12
+    int day;    // 1~31
+};
+
+// 距1970-01-01的天数 -> 公历日期，是daysFromCivil的逆运算
+inline CivilDate civilFromDays(int64_t days) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t shiftedMonth = (5 * dayOfYear + 2) / 153; // 从三月开始计数
+    int64_t day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    int64_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    int64_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+    return {static_cast<int>(year), static_cast<int>(month), static_cast<int>(day)};
+}
+
+// 本地时间相对UTC的偏移（秒），用于把时间对齐到本地的整点、零点和月份
+inline int64_t utcOffsetSeconds(std::time_t at) {
+    std::tm local = toLocalTime(at);
+    int64_t days = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+    int64_t asUtc = days * DAY_SECONDS + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+    return asUtc - static_cast<int64_t>(at);
+}
+
+// 进程启动时的时区偏移，只计算一次
+inline int64_t cachedUtcOffset() {
+    static const int64_t offset = utcOffsetSeconds(std::time(nullptr));
+    return offset;
+}
+
+// 本地时间的秒数（按UTC的算法即可得到本地日历字段）
+inline int64_t localSeconds(std::time_t time, int64_t utcOffset = cachedUtcOffset()) {
+    return static_cast<int64_t>(time) + utcOffset;
+}
+
+// 本地日期距1970-01-01的天数
+inline int64_t localDays(std::time_t time, int64_t utcOffset = cachedUtcOffset()) {
+    int64_t local = localSeconds(time, utcOffset);
+    return (local >= 0 ? local : local - (DAY_SECONDS - 1)) / DAY_SECONDS;
+}
+
+// 月份键：年份*100+月份（如202507），整数比较即时间先后
+inline int monthKey(std::time_t time, int64_t utcOffset = cachedUtcOffset()) {
+    CivilDate date = civilFromDays(localDays(time, utcOffset));
+    return date.year * 100 + date.month;
+}
+
+// 月份键 -> "YYYY-MM"，只在输出时调用
+inline std::string formatMonth(int key) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02d", key / 100, key % 100);
+    return text;
+}
+
+// 距1970-01-01的天数 -> "YYYY-MM-DD"
+inline std::string formatDate(int64_t days) {
+    CivilDate date = civilFromDays(days);
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", date.year, date.month, date.day);
+    return text;
+}
+
+} // namespace LocalTime
+
+#endif // LOCAL_TIME_H
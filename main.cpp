@@ -24,10 +24,62 @@
 #include "library_system.h"
 #include "http_server.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        // --lazy-catalog：图书目录保持在内存映射的快照中，按需解码
+        // --import/--export <users|books|records> <文件>：批量导入导出（.csv为CSV，否则为NDJSON），
+        //   可以重复多次，按顺序执行后退出，不启动服务器
+        bool lazyCatalog = false;
+        struct Transfer {
+            bool import;
+            std::string kind;
+            std::string path;
+        };
+        std::vector<Transfer> transfers;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--lazy-catalog") {
+                lazyCatalog = true;
+            } else if ((arg == "--import" || arg == "--export") && i + 2 < argc) {
+                transfers.push_back({arg == "--import", argv[i + 1], argv[i + 2]});
+                i += 2;
+            }
+        }
+        
         // 初始化图书管理系统
-        LibrarySystem library;
+        LibrarySystem library(lazyCatalog);
+        
+        if (!transfers.empty()) {
+            bool allOk = true;
+            for (const auto& transfer : transfers) {
+                auto showProgress = [&transfer](const BulkTransfer::Progress& progress) {
+                    std::cout << "\r" << (transfer.import ? "导入 " : "导出 ") << transfer.kind << ": "
+                              << static_cast<int>(progress.fraction() * 100) << "% (" << progress.records << " 条)"
+                              << std::flush;
+                };
+                auto start = std::chrono::steady_clock::now();
+                BulkTransfer::Report report = transfer.import
+                    ? library.importFile(transfer.kind, transfer.path, showProgress)
+                    : library.exportFile(transfer.kind, transfer.path, showProgress);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                
+                std::cout << std::endl;
+                if (!report.ok()) {
+                    std::cerr << transfer.path << ": " << report.fatal << std::endl;
+                    allOk = false;
+                    continue;
+                }
+                std::cout << transfer.path << ": 成功 " << report.succeeded << " 条，失败 " << report.failed
+                          << " 条，耗时 " << std::fixed << std::setprecision(2) << seconds << " 秒" << std::endl;
+                for (const auto& error : report.errors) {
+                    std::cerr << "  " << error << std::endl;
+                }
+                if (report.failed > report.errors.size()) {
+                    std::cerr << "  ……另有 " << report.failed - report.errors.size() << " 条错误未列出" << std::endl;
+                }
+            }
+            return allOk ? 0 : 1;
+        }
         
         // 加载测试数据
         library.loadTestData();
@@ -0,0 +1,59 @@
+#include "mapped_catalog.h"
+#include "library_system.h"
+
+bool MappedCatalog::open(const std::string& path) {
+    if (!reader_.map(path)) {
+        error_ = reader_.error();
+        return false;
+    }
+    table_ = reader_.findTable("books");
+    if (!table_) {
+        error_ = "快照中没有books表";
+        return false;
+    }
+    columns_ = reader_.bindColumns<Book>(*table_);
+    idColumn_ = columns_.front(); // 字段表的第一列是id
+    if (!idColumn_ && table_->rows > 0) {
+        error_ = "快照books表缺少id列";
+        return false;
+    }
+    for (const auto& column : table_->columns) {
+        if (column.name == "category" && column.kind == Snapshot::ColumnKind::String) {
+            categoryColumn_ = &column;
+        }
+    }
+    return true;
+}
+
+int MappedCatalog::idAt(uint32_t row) const {
+    return static_cast<int>(reader_.integerAt(*idColumn_, row));
+}
+
+std::optional<uint32_t> MappedCatalog::findRow(int bookId) const {
+    uint32_t low = 0;
+    uint32_t high = size();
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (idAt(mid) < bookId) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < size() && idAt(low) == bookId) {
+        return low;
+    }
+    return std::nullopt;
+}
+
+void MappedCatalog::decode(uint32_t row, Book& book) const {
+    reader_.decodeRow(columns_, row, book);
+}
+
+std::string_view MappedCatalog::categoryAt(uint32_t row) const {
+    return categoryColumn_ ? reader_.stringAt(*categoryColumn_, row) : std::string_view();
+}
+
+void MappedCatalog::copyRow(uint32_t row, Snapshot::TableBuilder<Book>& table) const {
+    table.copyRow(reader_, columns_, row);
+}
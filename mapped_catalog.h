@@ -0,0 +1,46 @@
+#ifndef MAPPED_CATALOG_H
+#define MAPPED_CATALOG_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include "snapshot.h"
+
+class Book;
+
+// 内存映射的图书目录：直接在快照文件上按行定位和解码图书，
+// 打开时只建立表目录，不解码任何行。快照中的图书按id升序存放。
+class MappedCatalog {
+public:
+    // 映射快照文件并定位books表；失败时返回false，error()给出原因
+    bool open(const std::string& path);
+    
+    const std::string& error() const { return error_; }
+    uint32_t size() const { return table_ ? table_->rows : 0; }
+    int idAt(uint32_t row) const;
+    int maxId() const { return size() > 0 ? idAt(size() - 1) : 0; }
+    
+    // 按id二分查找所在行
+    std::optional<uint32_t> findRow(int bookId) const;
+    
+    void decode(uint32_t row, Book& book) const;
+    // 只读取分类一列，不解码整行；快照中没有分类列时返回空串
+    std::string_view categoryAt(uint32_t row) const;
+    // 把一行原样复制到新快照的图书表，不解码
+    void copyRow(uint32_t row, Snapshot::TableBuilder<Book>& table) const;
+    
+    // 同一快照中的其他表（用户、借阅记录）也通过该映射读取
+    const Snapshot::Reader& reader() const { return reader_; }
+
+private:
+    Snapshot::Reader reader_;
+    const Snapshot::Table* table_ = nullptr;
+    const Snapshot::Column* idColumn_ = nullptr;
+    const Snapshot::Column* categoryColumn_ = nullptr;
+    std::vector<const Snapshot::Column*> columns_;
+    std::string error_;
+};
+
+#endif // MAPPED_CATALOG_H
@@ -0,0 +1,381 @@
+#include "record_archive.h"
+#include "library_system.h"
+#include "snapshot.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+
+namespace RecordArchive {
+
+namespace {
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void appendVarint(std::string& out, int64_t value) {
+    uint64_t bits = zigzag(value);
+    while (bits >= 0x80) {
+        out += static_cast<char>((bits & 0x7F) | 0x80);
+        bits >>= 7;
+    }
+    out += static_cast<char>(bits);
+}
+
+// 顺序读取一列varint，越界或编码错误时返回false
+class VarintReader {
+public:
+    explicit VarintReader(std::string_view data) : data_(data), pos_(0) {}
+    
+    bool next(int64_t& value) {
+        uint64_t bits = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos_ >= data_.size()) {
+                return false;
+            }
+            uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+            bits |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                value = unzigzag(bits);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    bool atEnd() const { return pos_ == data_.size(); }
+
+private:
+    std::string_view data_;
+    size_t pos_;
+};
+
+template <typename T>
+void appendColumn(std::string& out, const std::vector<T>& values, bool delta) {
+    std::string column;
+    column.reserve(values.size() * 2);
+    int64_t previous = 0;
+    for (T value : values) {
+        appendVarint(column, delta ? static_cast<int64_t>(value) - previous : static_cast<int64_t>(value));
+        previous = static_cast<int64_t>(value);
+    }
+    uint64_t length = column.size();
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out += column;
+}
+
+// 取出下一列的字节范围
+bool nextColumn(std::string_view& payload, std::string_view& column) {
+    uint64_t length;
+    if (payload.size() < sizeof(length)) {
+        return false;
+    }
+    std::memcpy(&length, payload.data(), sizeof(length));
+    payload.remove_prefix(sizeof(length));
+    if (length > payload.size()) {
+        return false;
+    }
+    column = payload.substr(0, static_cast<size_t>(length));
+    payload.remove_prefix(static_cast<size_t>(length));
+    return true;
+}
+
+template <typename T>
+bool decodeColumn(std::string_view& payload, uint32_t count, bool delta, std::vector<T>& out) {
+    std::string_view column;
+    if (!nextColumn(payload, column)) {
+        return false;
+    }
+    VarintReader reader(column);
+    out.resize(count);
+    int64_t previous = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int64_t value;
+        if (!reader.next(value)) {
+            return false;
+        }
+        previous = delta ? previous + value : value;
+        out[i] = static_cast<T>(previous);
+    }
+    return reader.atEnd();
+}
+
+// 布隆过滤器参数：每个不同的ID约10位、3个哈希时误判率约1%；单个过滤器最多128KB
+constexpr int FILTER_HASHES = 3;
+constexpr size_t FILTER_BITS_PER_ID = 10;
+constexpr size_t FILTER_MAX_WORDS = 1 << 14;
+
+uint64_t mixId(int id) {
+    uint64_t x = static_cast<uint64_t>(static_cast<uint32_t>(id)) + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 双重哈希：第i个位置为 h1 + i*h2，位图大小是2的幂
+template <typename Visitor>
+void forEachBit(int id, size_t bitCount, Visitor&& visitor) {
+    uint64_t hash = mixId(id);
+    uint64_t h1 = hash & 0xFFFFFFFFULL;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (int i = 0; i < FILTER_HASHES; ++i) {
+        visitor(static_cast<size_t>((h1 + i * h2) & (bitCount - 1)));
+    }
+}
+
+template <typename T>
+void appendScalar(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readScalar(std::string_view& in, T& value) {
+    if (in.size() < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+}
+
+void appendFilter(std::string& out, const IdFilter& filter) {
+    appendScalar<int32_t>(out, filter.minId);
+    appendScalar<int32_t>(out, filter.maxId);
+    appendScalar<uint32_t>(out, static_cast<uint32_t>(filter.bits.size()));
+    appendScalar<uint32_t>(out, 0);
+    out.append(reinterpret_cast<const char*>(filter.bits.data()), filter.bits.size() * sizeof(uint64_t));
+}
+
+bool readFilter(std::string_view& in, IdFilter& filter) {
+    int32_t minId;
+    int32_t maxId;
+    uint32_t words;
+    uint32_t reserved;
+    if (!readScalar(in, minId) || !readScalar(in, maxId) || !readScalar(in, words) || !readScalar(in, reserved) ||
+        words > FILTER_MAX_WORDS || (words != 0 && !std::has_single_bit(words)) ||
+        in.size() < words * sizeof(uint64_t)) {
+        return false;
+    }
+    filter.minId = minId;
+    filter.maxId = maxId;
+    filter.bits.resize(words);
+    std::memcpy(filter.bits.data(), in.data(), words * sizeof(uint64_t));
+    in.remove_prefix(words * sizeof(uint64_t));
+    return true;
+}
+
+// 读取并校验固定文件头
+bool readFixedHeader(std::ifstream& file, ArchiveHeader& header, std::string& error) {
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        error = "无法读取归档文件头";
+        return false;
+    }
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "归档魔数不匹配";
+        return false;
+    }
+    if (header.version < 1 || header.version > FORMAT_VERSION) {
+        error = "不支持的归档版本: " + std::to_string(header.version);
+        return false;
+    }
+    if (header.version < 3) {
+        header.summarySize = 0; // 早期版本此处为保留字段
+    }
+    return true;
+}
+
+} // namespace
+
+IdFilter IdFilter::build(const std::vector<int>& ids) {
+    IdFilter filter;
+    if (ids.empty()) {
+        return filter;
+    }
+    std::vector<int> distinct(ids);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    filter.minId = distinct.front();
+    filter.maxId = distinct.back();
+    
+    size_t words = std::bit_ceil((distinct.size() * FILTER_BITS_PER_ID + 63) / 64);
+    filter.bits.assign(std::min(words, FILTER_MAX_WORDS), 0);
+    size_t bitCount = filter.bits.size() * 64;
+    for (int id : distinct) {
+        forEachBit(id, bitCount, [&filter](size_t bit) { filter.bits[bit / 64] |= uint64_t(1) << (bit % 64); });
+    }
+    return filter;
+}
+
+bool IdFilter::mayContain(int id) const {
+    if (bits.empty()) {
+        return true;
+    }
+    if (id < minId || id > maxId) {
+        return false;
+    }
+    bool present = true;
+    forEachBit(id, bits.size() * 64, [&](size_t bit) { present = present && (bits[bit / 64] >> (bit % 64) & 1); });
+    return present;
+}
+
+Summary Summary::build(const Columns& columns) {
+    return Summary{IdFilter::build(columns.userIds), IdFilter::build(columns.bookIds)};
+}
+
+void Columns::reserve(size_t count) {
+    recordIds.reserve(count);
+    userIds.reserve(count);
+    bookIds.reserve(count);
+    borrowTimes.reserve(count);
+    returnTimes.reserve(count);
+    dueTimes.reserve(count);
+}
+
+void Columns::append(const BorrowRecord& record) {
+    recordIds.push_back(record.getRecordId());
+    userIds.push_back(record.getUserId());
+    bookIds.push_back(record.getBookId());
+    borrowTimes.push_back(record.getBorrowTime());
+    returnTimes.push_back(record.getReturnTime());
+    dueTimes.push_back(record.getDueTime());
+}
+
+BorrowRecord Columns::row(size_t index) const {
+    return BorrowRecord(recordIds[index], userIds[index], bookIds[index],
+                        borrowTimes[index], returnTimes[index], true, dueTimes[index]);
+}
+
+std::string encode(const Columns& columns) {
+    std::string payload;
+    payload.reserve(columns.size() * 12);
+    appendColumn(payload, columns.recordIds, true);
+    appendColumn(payload, columns.userIds, false);
+    appendColumn(payload, columns.bookIds, false);
+    appendColumn(payload, columns.borrowTimes, true);
+    
+    // 归还时间按借阅时长存储
+    std::vector<int64_t> durations(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        durations[i] = static_cast<int64_t>(columns.returnTimes[i]) - static_cast<int64_t>(columns.borrowTimes[i]);
+    }
+    appendColumn(payload, durations, false);
+    
+    // 借期几乎总是相同，按与前一条的差值存储
+    std::vector<int64_t> loanPeriods(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        loanPeriods[i] = columns.dueTimes[i] == 0
+                             ? 0
+                             : static_cast<int64_t>(columns.dueTimes[i]) - static_cast<int64_t>(columns.borrowTimes[i]);
+    }
+    appendColumn(payload, loanPeriods, true);
+    return payload;
+}
+
+bool decode(std::string_view payload, uint32_t count, Columns& out) {
+    std::vector<int64_t> durations;
+    if (!decodeColumn(payload, count, true, out.recordIds) ||
+        !decodeColumn(payload, count, false, out.userIds) ||
+        !decodeColumn(payload, count, false, out.bookIds) ||
+        !decodeColumn(payload, count, true, out.borrowTimes) ||
+        !decodeColumn(payload, count, false, durations)) {
+        return false;
+    }
+    out.returnTimes.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        out.returnTimes[i] = out.borrowTimes[i] + static_cast<std::time_t>(durations[i]);
+    }
+    
+    // 版本1的负载到此结束
+    out.dueTimes.assign(count, 0);
+    if (payload.empty()) {
+        return true;
+    }
+    std::vector<int64_t> loanPeriods;
+    if (!decodeColumn(payload, count, true, loanPeriods) || !payload.empty()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        out.dueTimes[i] = loanPeriods[i] == 0 ? 0 : out.borrowTimes[i] + static_cast<std::time_t>(loanPeriods[i]);
+    }
+    return true;
+}
+
+bool writeFile(const std::string& path, const Columns& columns, const Summary& summary) {
+    std::string payload = encode(columns);
+    
+    std::string summaryBytes;
+    appendFilter(summaryBytes, summary.users);
+    appendFilter(summaryBytes, summary.books);
+    appendScalar<uint64_t>(summaryBytes, Snapshot::checksum(summaryBytes.data(), summaryBytes.size()));
+    
+    ArchiveHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.count = static_cast<uint32_t>(columns.size());
+    header.maxRecordId = columns.recordIds.empty() ? 0 : columns.recordIds.back();
+    header.summarySize = static_cast<uint32_t>(summaryBytes.size());
+    header.payloadSize = payload.size();
+    header.checksum = Snapshot::checksum(payload.data(), payload.size());
+    
+    std::string file(reinterpret_cast<const char*>(&header), sizeof(header));
+    file += summaryBytes;
+    file += payload;
+    return Snapshot::writeFileAtomically(path, file);
+}
+
+bool readHeader(const std::string& path, ArchiveHeader& header, Summary& summary, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!readFixedHeader(file, header, error)) {
+        return false;
+    }
+    summary = Summary{};
+    if (header.summarySize == 0) {
+        return true;
+    }
+    
+    std::string bytes(header.summarySize, '\0');
+    if (bytes.size() < sizeof(uint64_t) || !file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+        error = "无法读取归档摘要";
+        return true;
+    }
+    std::string_view in(bytes.data(), bytes.size() - sizeof(uint64_t));
+    uint64_t expected;
+    std::memcpy(&expected, bytes.data() + in.size(), sizeof(expected));
+    if (Snapshot::checksum(in.data(), in.size()) != expected || !readFilter(in, summary.users) ||
+        !readFilter(in, summary.books) || !in.empty()) {
+        summary = Summary{};
+        error = "归档摘要损坏";
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, ArchiveHeader& header, std::string& payload, std::string& error) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    if (!readFixedHeader(file, header, error)) {
+        return false;
+    }
+    if (fileSize != sizeof(header) + header.summarySize + header.payloadSize) {
+        error = "归档长度不匹配（文件可能被截断）";
+        return false;
+    }
+    payload.resize(static_cast<size_t>(header.payloadSize));
+    file.seekg(sizeof(header) + header.summarySize);
+    if (!file.read(payload.data(), static_cast<std::streamsize>(payload.size()))) {
+        error = "读取归档负载失败";
+        return false;
+    }
+    if (Snapshot::checksum(payload.data(), payload.size()) != header.checksum) {
+        error = "归档校验和不匹配";
+        return false;
+    }
+    return true;
+}
+
+} // namespace RecordArchive
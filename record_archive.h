@@ -0,0 +1,96 @@
+#ifndef RECORD_ARCHIVE_H
+#define RECORD_ARCHIVE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+
+class BorrowRecord;
+
+// 已归还借阅记录的列式归档格式。
+//
+// 内存中每个已关闭段只保留编码后的负载（每条记录通常只有几个字节），
+// 扫描时再解码成平行数组，统计和历史查询都是对数组的顺序循环。
+//
+// 文件布局（小端）：
+//   ArchiveHeader                    魔数、版本、记录数、最大记录id、摘要长度、负载长度、负载校验和
+//   摘要（版本3起）：读者ID和图书ID各一个IdFilter，再加u64摘要校验和
+//     IdFilter：i32 最小值, i32 最大值, u32 字数, u32 保留, u64 × 字数 布隆过滤器位图
+//   负载：列 × 6，每列 u64 字节数 + varint序列
+//     recordId     与前一条的差值（记录按id升序）
+//     userId       原值
+//     bookId       原值
+//     borrowTime   与前一条的差值
+//     returnTime   与本条borrowTime的差值（即借阅时长）
+//     dueTime      借期（与borrowTime的差值）再与前一条借期的差值，借期相同时每条1字节
+// 所有varint都先做zigzag变换，负数同样紧凑。版本1的文件没有dueTime列，读出为0。
+// 摘要随文件头读入，按读者或图书查询时据此跳过不可能含有匹配记录的段；早期版本没有摘要，总是扫描。
+namespace RecordArchive {
+
+constexpr char MAGIC[8] = {'L', 'I', 'B', 'A', 'R', 'C', 'H', '\0'};
+constexpr uint32_t FORMAT_VERSION = 3;
+
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int32_t maxRecordId;
+    uint32_t summarySize; // 紧跟文件头的摘要字节数；版本3之前为0
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+static_assert(sizeof(ArchiveHeader) == 40, "ArchiveHeader必须是固定布局");
+
+// 解码后的平行数组，下标相同的元素属于同一条记录
+struct Columns {
+    std::vector<int> recordIds;
+    std::vector<int> userIds;
+    std::vector<int> bookIds;
+    std::vector<std::time_t> borrowTimes;
+    std::vector<std::time_t> returnTimes;
+    std::vector<std::time_t> dueTimes;
+    
+    size_t size() const { return recordIds.size(); }
+    void reserve(size_t count);
+    void append(const BorrowRecord& record);
+    BorrowRecord row(size_t index) const;
+};
+
+// 一列ID的取值范围和布隆过滤器（3个哈希，每个不同的ID约10位，误判率约1%）。
+// 没有位图时（早期版本的段）任何ID都可能存在
+struct IdFilter {
+    int minId = 0;
+    int maxId = 0;
+    std::vector<uint64_t> bits;
+    
+    static IdFilter build(const std::vector<int>& ids);
+    bool mayContain(int id) const;
+};
+
+// 段摘要：按读者、按图书查询时判断能否跳过该段
+struct Summary {
+    IdFilter users;
+    IdFilter books;
+    
+    static Summary build(const Columns& columns);
+};
+
+// 编码/解码负载（不含文件头）；columns须按recordId升序
+std::string encode(const Columns& columns);
+bool decode(std::string_view payload, uint32_t count, Columns& out);
+
+// 原子写入归档文件；summary须由同一份columns生成
+bool writeFile(const std::string& path, const Columns& columns, const Summary& summary);
+
+// 只读取并校验文件头和摘要，不读负载。文件头无效时返回false；
+// 只有摘要损坏时仍返回true（header有效），summary为空（不能据此跳过任何ID），error给出原因
+bool readHeader(const std::string& path, ArchiveHeader& header, Summary& summary, std::string& error);
+
+// 读取负载并校验长度和校验和
+bool readFile(const std::string& path, ArchiveHeader& header, std::string& payload, std::string& error);
+
+} // namespace RecordArchive
+
+#endif // RECORD_ARCHIVE_H
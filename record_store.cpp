@@ -0,0 +1,339 @@
+#include "record_store.h"
+#include "library_system.h"
+#include "snapshot.h"
+#include "local_time.h"
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+#include <cstdio>
+
+RecordStore::RecordStore(std::string directory) : directory_(std::move(directory)) {}
+
+RecordStore::~RecordStore() = default;
+
+int RecordStore::monthKey(std::time_t time) {
+    return LocalTime::monthKey(time);
+}
+
+std::string RecordStore::segmentPath(int month) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%04d-%02d.arc", month / 100, month % 100);
+    return directory_ + "/" + name;
+}
+
+void RecordStore::open() {
+    closed_.clear();
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+        // 段文件名形如 2025-07.arc；.tmp 等其他文件忽略
+        int year = 0;
+        int month = 0;
+        std::string stem = entry.path().stem().string();
+        std::string extension = entry.path().extension().string();
+        if ((extension != ".arc" && extension != ".snap") || stem.size() != 7 || stem[4] != '-' ||
+            std::sscanf(stem.c_str(), "%4d-%2d", &year, &month) != 2 || month < 1 || month > 12) {
+            continue;
+        }
+        if (extension == ".snap") {
+            migrateLegacySegment(year * 100 + month, entry.path().string());
+            continue;
+        }
+        
+        RecordArchive::ArchiveHeader header;
+        RecordArchive::Summary summary;
+        std::string error;
+        Segment& segment = closed_[year * 100 + month];
+        if (!RecordArchive::readHeader(entry.path().string(), header, summary, error)) {
+            // 记录数和最大id都无从得知；文件原样保留，留给人工恢复
+            std::cerr << "借阅记录段不可用(" << error << "): " << entry.path().string() << std::endl;
+            segment.failed = true;
+            continue;
+        }
+        segment.rows = header.count;
+        segment.maxId = header.maxRecordId;
+        segment.summary = std::move(summary);
+        if (!error.empty()) {
+            std::cerr << "借阅记录段" << error << "，将从负载重建: " << entry.path().string() << std::endl;
+        }
+        if ((header.summarySize == 0 || !error.empty()) && segment.rows > 0) {
+            addSummary(year * 100 + month, segment);
+        }
+    }
+}
+
+void RecordStore::addSummary(int month, Segment& segment) {
+    // 版本3之前的段没有摘要，摘要损坏的段也不能据此跳过，按ID查询时只能逐段扫描；读出后带上摘要重写。
+    // 负载读不出来时该段成为失败段；只是重写失败时保留原文件，该段照常可用，查询时不能跳过
+    RecordArchive::Columns columns;
+    if (!scanSegment(month, [&columns](const RecordArchive::Columns& decoded) { columns = decoded; })) {
+        return;
+    }
+    RecordArchive::Summary summary = RecordArchive::Summary::build(columns);
+    if (!RecordArchive::writeFile(segmentPath(month), columns, summary)) {
+        std::cerr << "为借阅记录段补写摘要失败: " << segmentPath(month) << std::endl;
+        return;
+    }
+    segment.summary = std::move(summary);
+}
+
+void RecordStore::migrateLegacySegment(int month, const std::string& path) {
+    // 早期版本用快照格式保存已关闭段，读出后转存为列式归档
+    Snapshot::Reader reader;
+    std::vector<std::unique_ptr<BorrowRecord>> records;
+    try {
+        if (!reader.load(path)) {
+            throw std::runtime_error(reader.error());
+        }
+        reader.readTable("records", records);
+    } catch (const std::exception& e) {
+        // 同样保留为失败段，rollOver不会为该月另写归档
+        std::cerr << "旧格式借阅记录段不可用(" << e.what() << "): " << path << std::endl;
+        closed_[month].failed = true;
+        return;
+    }
+    
+    RecordArchive::Columns columns;
+    columns.reserve(records.size());
+    for (const auto& record : records) {
+        columns.append(*record);
+    }
+    RecordArchive::Summary summary = RecordArchive::Summary::build(columns);
+    if (!RecordArchive::writeFile(segmentPath(month), columns, summary)) {
+        std::cerr << "转换借阅记录段失败: " << path << std::endl;
+        closed_[month].failed = true;
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    
+    Segment& segment = closed_[month];
+    segment.rows = static_cast<uint32_t>(columns.size());
+    segment.maxId = columns.recordIds.empty() ? 0 : columns.recordIds.back();
+    segment.summary = std::move(summary);
+}
+
+void RecordStore::replaceActive(std::vector<std::unique_ptr<BorrowRecord>> records) {
+    active_ = std::move(records);
+}
+
+BorrowRecord* RecordStore::add(std::unique_ptr<BorrowRecord> record) {
+    active_.push_back(std::move(record));
+    return active_.back().get();
+}
+
+BorrowRecord* RecordStore::findOpen(int userId, int bookId) {
+    for (const auto& record : active_) {
+        if (record->getUserId() == userId && record->getBookId() == bookId && !record->getIsReturned()) {
+            return record.get();
+        }
+    }
+    return nullptr;
+}
+
+size_t RecordStore::size() const {
+    size_t total = active_.size();
+    for (const auto& entry : closed_) {
+        total += entry.second.rows;
+    }
+    return total;
+}
+
+int RecordStore::maxRecordId() const {
+    int maxId = 0;
+    for (const auto& entry : closed_) {
+        maxId = std::max(maxId, entry.second.maxId);
+    }
+    for (const auto& record : active_) {
+        maxId = std::max(maxId, record->getRecordId());
+    }
+    return maxId;
+}
+
+bool RecordStore::loadSegment(int month, Segment& segment) {
+    if (segment.failed) {
+        return false;
+    }
+    if (segment.loaded) {
+        return true;
+    }
+    if (segment.rows > 0) {
+        RecordArchive::ArchiveHeader header;
+        std::string error;
+        std::string path = segmentPath(month);
+        if (!RecordArchive::readFile(path, header, segment.payload, error)) {
+            std::cerr << "借阅记录段不可用(" << error << "): " << path << std::endl;
+            segment.payload.clear();
+            segment.failed = true;
+            return false;
+        }
+        segment.rows = header.count;
+    }
+    segment.loaded = true;
+    return true;
+}
+
+bool RecordStore::scanSegment(int month, const std::function<void(const RecordArchive::Columns&)>& visitor) {
+    auto it = closed_.find(month);
+    if (it == closed_.end() || !loadSegment(month, it->second)) {
+        return false;
+    }
+    RecordArchive::Columns columns;
+    if (!RecordArchive::decode(it->second.payload, it->second.rows, columns)) {
+        std::cerr << "借阅记录段损坏: " << segmentPath(month) << std::endl;
+        it->second.payload.clear();
+        it->second.failed = true;
+        return false;
+    }
+    visitor(columns);
+    return true;
+}
+
+bool RecordStore::rollOver(std::time_t now) {
+    int current = monthKey(now);
+    std::map<int, std::vector<std::unique_ptr<BorrowRecord>>> closing;
+    auto kept = active_.begin();
+    for (auto& record : active_) {
+        int month = record->getIsReturned() ? monthKey(record->getReturnTime()) : current;
+        if (month < current) {
+            closing[month].push_back(std::move(record));
+        } else {
+            *kept++ = std::move(record);
+        }
+    }
+    active_.erase(kept, active_.end());
+    if (closing.empty()) {
+        return true;
+    }
+    
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    
+    bool ok = true;
+    for (auto& [month, incoming] : closing) {
+        // 段已存在时先读出已有记录；读不出来（包括打开时就失败的段）就不覆盖它，记录留在活动段
+        RecordArchive::Columns existing;
+        bool segmentExists = closed_.count(month) > 0;
+        if (segmentExists && !scanSegment(month, [&existing](const RecordArchive::Columns& columns) {
+                existing = columns;
+            })) {
+            for (auto& record : incoming) {
+                active_.push_back(std::move(record));
+            }
+            ok = false;
+            continue;
+        }
+        
+        // 合并已有记录和新关闭的记录，按id排序后重新编码
+        std::unordered_set<int> existingIds(existing.recordIds.begin(), existing.recordIds.end());
+        std::vector<BorrowRecord> rows;
+        rows.reserve(existing.size() + incoming.size());
+        for (size_t i = 0; i < existing.size(); ++i) {
+            rows.push_back(existing.row(i));
+        }
+        for (const auto& record : incoming) {
+            if (!existingIds.count(record->getRecordId())) {
+                rows.push_back(*record);
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const BorrowRecord& a, const BorrowRecord& b) {
+            return a.getRecordId() < b.getRecordId();
+        });
+        RecordArchive::Columns sorted;
+        sorted.reserve(rows.size());
+        for (const auto& record : rows) {
+            sorted.append(record);
+        }
+        
+        std::string path = segmentPath(month);
+        RecordArchive::Summary summary = RecordArchive::Summary::build(sorted);
+        if (!RecordArchive::writeFile(path, sorted, summary)) {
+            // 写盘失败时记录留在活动段，随活动段一起保存，下次再尝试
+            std::cerr << "写入借阅记录段失败: " << path << std::endl;
+            for (auto& record : incoming) {
+                active_.push_back(std::move(record));
+            }
+            ok = false;
+            continue;
+        }
+        
+        Segment& segment = closed_[month];
+        segment.payload = RecordArchive::encode(sorted);
+        segment.rows = static_cast<uint32_t>(sorted.size());
+        segment.maxId = sorted.recordIds.empty() ? 0 : sorted.recordIds.back();
+        segment.summary = std::move(summary);
+        segment.loaded = true;
+    }
+    return ok;
+}
+
+std::vector<int> RecordStore::closedMonths() const {
+    std::vector<int> months;
+    for (const auto& entry : closed_) {
+        months.push_back(entry.first);
+    }
+    return months;
+}
+
+std::vector<BorrowRecord> RecordStore::all() {
+    std::vector<BorrowRecord> result;
+    result.reserve(size());
+    for (const auto& entry : closed_) {
+        scanSegment(entry.first, [&result](const RecordArchive::Columns& columns) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                result.push_back(columns.row(i));
+            }
+        });
+    }
+    for (const auto& record : active_) {
+        result.push_back(*record);
+    }
+    return result;
+}
+
+void RecordStore::forEach(const std::function<void(const BorrowRecord&)>& visitor) {
+    for (const auto& entry : closed_) {
+        scanSegment(entry.first, [&visitor](const RecordArchive::Columns& columns) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                visitor(columns.row(i));
+            }
+        });
+    }
+    for (const auto& record : active_) {
+        visitor(*record);
+    }
+}
+
+std::vector<BorrowRecord> RecordStore::select(const std::vector<int> RecordArchive::Columns::* column,
+                                              const RecordArchive::IdFilter RecordArchive::Summary::* filter,
+                                              int (BorrowRecord::* getter)() const, int value) {
+    std::vector<BorrowRecord> result;
+    for (const auto& entry : closed_) {
+        // 摘要排除的段不读入也不解码；摘要可能误判为包含，扫描时仍逐行比较
+        if (!(entry.second.summary.*filter).mayContain(value)) {
+            continue;
+        }
+        scanSegment(entry.first, [&](const RecordArchive::Columns& columns) {
+            const std::vector<int>& values = columns.*column;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i] == value) {
+                    result.push_back(columns.row(i));
+                }
+            }
+        });
+    }
+    for (const auto& record : active_) {
+        if (((*record).*getter)() == value) {
+            result.push_back(*record);
+        }
+    }
+    return result;
+}
+
+std::vector<BorrowRecord> RecordStore::byUser(int userId) {
+    return select(&RecordArchive::Columns::userIds, &RecordArchive::Summary::users, &BorrowRecord::getUserId, userId);
+}
+
+std::vector<BorrowRecord> RecordStore::byBook(int bookId) {
+    return select(&RecordArchive::Columns::bookIds, &RecordArchive::Summary::books, &BorrowRecord::getBookId, bookId);
+}
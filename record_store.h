@@ -0,0 +1,87 @@
+#ifndef RECORD_STORE_H
+#define RECORD_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <ctime>
+#include "record_archive.h"
+
+class BorrowRecord;
+
+// 按月分段的借阅记录存储。
+//
+// 活动段：所有未归还的记录和本月归还的记录，可修改，随主快照和records.json一起保存。
+// 已关闭段：某个过去月份内归还的记录，每月一个列式归档文件（如 data/records/2025-07.arc），
+// 写入后不再改变。启动时只读取各段的文件头和读者/图书ID摘要，段负载在首次访问时才读入，
+// 之后以编码形式常驻内存，扫描时解码成平行数组。按读者或图书查询时先查摘要，
+// 不可能包含该ID的段既不读入也不解码。
+class RecordStore {
+public:
+    explicit RecordStore(std::string directory);
+    ~RecordStore();
+    RecordStore(const RecordStore&) = delete;
+    RecordStore& operator=(const RecordStore&) = delete;
+    
+    // 扫描已关闭段目录，只读取文件头和摘要；没有摘要或摘要损坏的段就地重写一次。
+    // 读不出来的段也保留为失败段：不能扫描，但rollOver不会覆盖该月的文件
+    void open();
+    
+    const std::vector<std::unique_ptr<BorrowRecord>>& active() const { return active_; }
+    void replaceActive(std::vector<std::unique_ptr<BorrowRecord>> records);
+    BorrowRecord* add(std::unique_ptr<BorrowRecord> record);
+    
+    // 未归还的借阅一定在活动段中，因此只查活动段
+    BorrowRecord* findOpen(int userId, int bookId);
+    
+    size_t size() const;
+    int maxRecordId() const;
+    
+    // 把过去月份内归还的记录移出活动段，写入对应月份的已关闭段。
+    // 段文件已存在时（如崩溃后重放）按记录id合并，不会产生重复记录；
+    // 已有的段读不出来时不写该月，记录留在活动段
+    bool rollOver(std::time_t now);
+    
+    // 已关闭段的月份（升序，形如202507）
+    std::vector<int> closedMonths() const;
+    
+    // 解码某个已关闭段并交给visitor；段不存在或损坏时返回false。
+    // 首次访问时读入段负载，不同线程可以同时扫描不同的月份
+    bool scanSegment(int month, const std::function<void(const RecordArchive::Columns&)>& visitor);
+    
+    // 按月份顺序返回所有记录的副本（先已关闭段，后活动段）
+    std::vector<BorrowRecord> all();
+    // 与all()顺序相同，但逐段解码后逐条交给visitor，不复制全部记录
+    void forEach(const std::function<void(const BorrowRecord&)>& visitor);
+    std::vector<BorrowRecord> byUser(int userId);
+    std::vector<BorrowRecord> byBook(int bookId);
+    
+    // 本地时间的年月键，如 2025年7月 -> 202507
+    static int monthKey(std::time_t time);
+
+private:
+    struct Segment {
+        uint32_t rows = 0;
+        int maxId = 0;
+        bool loaded = false;
+        bool failed = false; // 文件头或负载读不出来；保留该月是为了不被rollOver覆盖
+        RecordArchive::Summary summary;
+        std::string payload; // 编码后的列，见 record_archive.h
+    };
+    
+    std::string segmentPath(int month) const;
+    bool loadSegment(int month, Segment& segment);
+    void migrateLegacySegment(int month, const std::string& path);
+    void addSummary(int month, Segment& segment);
+    std::vector<BorrowRecord> select(const std::vector<int> RecordArchive::Columns::* column,
+                                     const RecordArchive::IdFilter RecordArchive::Summary::* filter,
+                                     int (BorrowRecord::* getter)() const, int value);
+    
+    std::string directory_;
+    std::vector<std::unique_ptr<BorrowRecord>> active_;
+    std::map<int, Segment> closed_;
+};
+
+#endif // RECORD_STORE_H
@@ -0,0 +1,105 @@
+#ifndef ROLLING_COUNTER_H
+#define ROLLING_COUNTER_H
+
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+
+// 固定内存的环形时间序列：保存最近capacity个等宽时间桶内的借出/归还次数。
+//
+// 桶编号 = floor((时间 + origin) / width)，origin用于对齐到本地时区的整点/零点/周一。
+// 每个槽位记录自己当前属于哪个桶，槽位被新的桶复用时自动清零，
+// 因此更新是O(1)，查询最近n个桶是O(n)，不需要定期清理。
+class RollingCounter {
+public:
+    struct Bucket {
+        std::time_t start;
+        int borrows;
+        int returns;
+    };
+    
+    RollingCounter(int64_t width, size_t capacity, int64_t origin = 0)
+        : width_(width), origin_(origin), slots_(capacity) {}
+    
+    void addBorrow(std::time_t time, int count = 1) {
+        if (Slot* slot = slotFor(bucketOf(time))) slot->borrows += count;
+    }
+    
+    void addReturn(std::time_t time, int count = 1) {
+        if (Slot* slot = slotFor(bucketOf(time))) slot->returns += count;
+    }
+    
+    // 截至now的最近n个桶（n不超过容量），按时间从早到晚排列
+    std::vector<Bucket> last(size_t n, std::time_t now) const {
+        n = std::min(n, slots_.size());
+        int64_t current = bucketOf(now);
+        std::vector<Bucket> result;
+        result.reserve(n);
+        for (int64_t index = current - static_cast<int64_t>(n) + 1; index <= current; ++index) {
+            const Slot& slot = slots_[position(index)];
+            bool live = slot.index == index;
+            result.push_back({static_cast<std::time_t>(index * width_ - origin_),
+                              live ? slot.borrows : 0, live ? slot.returns : 0});
+        }
+        return result;
+    }
+    
+    // 累加另一份同规格的序列（多线程重建统计时合并局部结果）
+    void merge(const RollingCounter& other) {
+        for (const Slot& theirs : other.slots_) {
+            if (theirs.index == NO_BUCKET) continue;
+            if (Slot* slot = slotFor(theirs.index)) {
+                slot->borrows += theirs.borrows;
+                slot->returns += theirs.returns;
+            }
+        }
+    }
+    
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), Slot{});
+        latest_ = NO_BUCKET;
+    }
+    
+    int64_t width() const { return width_; }
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    static constexpr int64_t NO_BUCKET = INT64_MIN;
+    
+    struct Slot {
+        int64_t index = NO_BUCKET;
+        int borrows = 0;
+        int returns = 0;
+    };
+    
+    int64_t bucketOf(std::time_t time) const {
+        int64_t shifted = static_cast<int64_t>(time) + origin_;
+        return shifted >= 0 ? shifted / width_ : (shifted - width_ + 1) / width_;
+    }
+    
+    size_t position(int64_t index) const {
+        int64_t size = static_cast<int64_t>(slots_.size());
+        return static_cast<size_t>(((index % size) + size) % size);
+    }
+    
+    // 取桶对应的槽位；比窗口还早的事件直接丢弃
+    Slot* slotFor(int64_t index) {
+        if (latest_ != NO_BUCKET && index + static_cast<int64_t>(slots_.size()) <= latest_) {
+            return nullptr;
+        }
+        latest_ = std::max(latest_, index);
+        Slot& slot = slots_[position(index)];
+        if (slot.index != index) {
+            slot = Slot{index, 0, 0};
+        }
+        return &slot;
+    }
+    
+    int64_t width_;
+    int64_t origin_;
+    int64_t latest_ = NO_BUCKET;
+    std::vector<Slot> slots_;
+};
+
+#endif // ROLLING_COUNTER_H
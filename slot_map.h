@@ -0,0 +1,190 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+// 实体池：对象按块连续存放，删除后空出的槽位经空闲链表复用，增删都不移动其他对象。
+//
+// 每个槽位带一个代数：被占用时为奇数，释放时加一变为偶数，再次占用时再加一。
+// 句柄记录槽位号和占用时的代数，槽位释放或被复用后旧句柄取不到对象，不会指向别的实体。
+// 扩容只追加新块，对象地址在其生命周期内不变，T*可以像unique_ptr持有的指针一样长期使用。
+// 遍历按槽位顺序线性扫描（复用槽位后不再是插入顺序）。
+template <typename T>
+class SlotMap {
+public:
+    struct Handle {
+        uint32_t index = 0;
+        uint32_t generation = 0; // 0永远不是有效代数，默认构造的句柄取不到对象
+    };
+    
+    static constexpr size_t CHUNK_SIZE = 1024;
+    
+    SlotMap() = default;
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+    SlotMap(SlotMap&& other) noexcept { swap(other); }
+    SlotMap& operator=(SlotMap&& other) noexcept {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+    ~SlotMap() { clear(); }
+    
+    template <typename... Args>
+    Handle emplace(Args&&... args) {
+        uint32_t index;
+        if (!free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(generations_.size());
+            if (index / CHUNK_SIZE == chunks_.size()) {
+                chunks_.emplace_back(new Chunk);
+            }
+            generations_.push_back(0);
+        }
+        try {
+            new (address(index)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            free_.push_back(index);
+            throw;
+        }
+        ++size_;
+        return Handle{index, ++generations_[index]};
+    }
+    
+    // 句柄已失效（对象被删除或槽位被复用）时返回nullptr
+    T* get(Handle handle) {
+        return isLive(handle) ? object(handle.index) : nullptr;
+    }
+    const T* get(Handle handle) const {
+        return isLive(handle) ? object(handle.index) : nullptr;
+    }
+    
+    bool erase(Handle handle) {
+        if (!isLive(handle)) {
+            return false;
+        }
+        object(handle.index)->~T();
+        ++generations_[handle.index];
+        free_.push_back(handle.index);
+        --size_;
+        return true;
+    }
+    
+    // 预先分配至少容纳count个对象的块，避免批量插入时逐块分配
+    void reserve(size_t count) {
+        generations_.reserve(count);
+        chunks_.reserve((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        while (chunks_.size() * CHUNK_SIZE < count) {
+            chunks_.emplace_back(new Chunk);
+        }
+    }
+    
+    void clear() {
+        for (uint32_t index = 0; index < generations_.size(); ++index) {
+            if (generations_[index] % 2 != 0) {
+                object(index)->~T();
+            }
+        }
+        chunks_.clear();
+        generations_.clear();
+        free_.clear();
+        size_ = 0;
+    }
+    
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    
+    // 按槽位顺序遍历存活的对象，解引用得到T&
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using Owner = std::conditional_t<Const, const SlotMap, SlotMap>;
+        
+        Iterator() = default;
+        Iterator(Owner* owner, uint32_t index) : owner_(owner), index_(index) { skipFree(); }
+        
+        reference operator*() const { return *owner_->object(index_); }
+        pointer operator->() const { return owner_->object(index_); }
+        Iterator& operator++() {
+            ++index_;
+            skipFree();
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+        
+        // 当前对象的句柄
+        Handle handle() const { return Handle{index_, owner_->generations_[index_]}; }
+    
+    private:
+        void skipFree() {
+            while (index_ < owner_->generations_.size() && owner_->generations_[index_] % 2 == 0) {
+                ++index_;
+            }
+        }
+        
+        Owner* owner_ = nullptr;
+        uint32_t index_ = 0;
+    };
+    
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+    
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, static_cast<uint32_t>(generations_.size())); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, static_cast<uint32_t>(generations_.size())); }
+
+private:
+    // 未初始化的存储，对象用placement new构造在其中
+    struct Chunk {
+        alignas(T) std::byte bytes[CHUNK_SIZE * sizeof(T)];
+    };
+    
+    bool isLive(Handle handle) const {
+        return handle.index < generations_.size() && generations_[handle.index] == handle.generation &&
+               handle.generation % 2 != 0;
+    }
+    
+    void* address(uint32_t index) const {
+        return chunks_[index / CHUNK_SIZE]->bytes + (index % CHUNK_SIZE) * sizeof(T);
+    }
+    T* object(uint32_t index) const {
+        return std::launder(static_cast<T*>(address(index)));
+    }
+    
+    void swap(SlotMap& other) noexcept {
+        chunks_.swap(other.chunks_);
+        generations_.swap(other.generations_);
+        free_.swap(other.free_);
+        std::swap(size_, other.size_);
+    }
+    
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    std::vector<uint32_t> generations_; // 已使用过的槽位的代数，奇数表示被占用
+    std::vector<uint32_t> free_;        // 空闲槽位，后进先出
+    size_t size_ = 0;
+};
+
+#endif // SLOT_MAP_H
@@ -0,0 +1,142 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+// 小容量内联向量：不超过N个元素时存放在对象内部，不做堆分配，超过后才转到堆上。
+//
+// 用于绝大多数实体只有几个元素的列表（读者的在借图书、每册副本的借阅者、副本位图）：
+// 几百万个实体各省一次分配，遍历时也不用再跳到另一块内存。
+// 内联数组与堆指针共用同一块空间，只支持可平凡复制的元素类型，搬移时直接memcpy。
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector只支持可平凡复制的元素");
+    static_assert(N > 0, "内联容量至少为1");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+    
+    SmallVector() = default;
+    SmallVector(size_t count, const T& value) { assign(count, value); }
+    SmallVector(const SmallVector& other) { copyFrom(other); }
+    SmallVector(SmallVector&& other) noexcept { stealFrom(other); }
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            size_ = 0;
+            copyFrom(other);
+        }
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            stealFrom(other);
+        }
+        return *this;
+    }
+    ~SmallVector() { release(); }
+    
+    T* data() { return isInline() ? storage_.inline_ : storage_.heap_; }
+    const T* data() const { return isInline() ? storage_.inline_ : storage_.heap_; }
+    iterator begin() { return data(); }
+    iterator end() { return data() + size_; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size_; }
+    
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t index) { return data()[index]; }
+    const T& operator[](size_t index) const { return data()[index]; }
+    T& front() { return data()[0]; }
+    const T& front() const { return data()[0]; }
+    T& back() { return data()[size_ - 1]; }
+    const T& back() const { return data()[size_ - 1]; }
+    
+    void push_back(const T& value) {
+        T copy = value; // value可能指向本向量中的元素，扩容前先复制
+        if (size_ == capacity_) {
+            grow(static_cast<size_t>(capacity_) * 2);
+        }
+        data()[size_++] = copy;
+    }
+    
+    iterator erase(const_iterator position) {
+        T* target = data() + (position - data());
+        std::memmove(target, target + 1, (end() - target - 1) * sizeof(T));
+        --size_;
+        return target;
+    }
+    
+    void clear() { size_ = 0; }
+    
+    void reserve(size_t count) {
+        if (count > capacity_) {
+            grow(count);
+        }
+    }
+    
+    void resize(size_t count, const T& value = T{}) {
+        reserve(count);
+        std::fill(data() + size_, data() + std::max<size_t>(count, size_), value);
+        size_ = static_cast<uint32_t>(count);
+    }
+    
+    void assign(size_t count, const T& value) {
+        clear();
+        resize(count, value);
+    }
+
+private:
+    bool isInline() const { return capacity_ == N; }
+    
+    void grow(size_t count) {
+        T* heap = new T[count];
+        std::memcpy(heap, data(), size_ * sizeof(T));
+        release();
+        storage_.heap_ = heap;
+        capacity_ = static_cast<uint32_t>(count);
+    }
+    
+    void release() {
+        if (!isInline()) {
+            delete[] storage_.heap_;
+            capacity_ = N;
+        }
+    }
+    
+    void copyFrom(const SmallVector& other) {
+        reserve(other.size_);
+        std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+    
+    // 本对象须为内联状态；对方在堆上时直接接管其缓冲区
+    void stealFrom(SmallVector& other) {
+        if (other.isInline()) {
+            std::memcpy(storage_.inline_, other.storage_.inline_, other.size_ * sizeof(T));
+        } else {
+            storage_.heap_ = other.storage_.heap_;
+            capacity_ = other.capacity_;
+            other.capacity_ = N;
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+    
+    union Storage {
+        T inline_[N];
+        T* heap_;
+    } storage_;
+    uint32_t size_ = 0;
+    uint32_t capacity_ = N;
+};
+
+#endif // SMALL_VECTOR_H
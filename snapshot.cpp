@@ -0,0 +1,376 @@
+#include "snapshot.h"
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Snapshot {
+
+uint64_t checksum(const char* data, size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL;
+    
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+    return hash;
+}
+
+uint32_t Writer::symbolOffset(Symbol symbol) {
+    if (symbol.id() >= symbolOffsets_.size()) {
+        symbolOffsets_.resize(symbol.id() + 1, NOT_WRITTEN);
+    }
+    uint32_t& offset = symbolOffsets_[symbol.id()];
+    if (offset == NOT_WRITTEN) {
+        offset = heapOffset(strings_.size());
+        strings_ += symbol.str();
+    }
+    return offset;
+}
+
+std::string Writer::finish() const {
+    std::string payload;
+    payload.reserve(16 + strings_.size() + ints_.size() * sizeof(int32_t) + tables_.size());
+    
+    uint64_t stringsSize = strings_.size();
+    payload.append(reinterpret_cast<const char*>(&stringsSize), sizeof(stringsSize));
+    payload += strings_;
+    
+    uint64_t intCount = ints_.size();
+    payload.append(reinterpret_cast<const char*>(&intCount), sizeof(intCount));
+    payload.append(reinterpret_cast<const char*>(ints_.data()), ints_.size() * sizeof(int32_t));
+    
+    payload += tables_;
+    
+    // 块校验和跟在负载后面，映射读取时按块校验
+    std::string blockChecksums;
+    blockChecksums.reserve((payload.size() + BLOCK_SIZE - 1) / BLOCK_SIZE * sizeof(uint64_t));
+    for (size_t pos = 0; pos < payload.size(); pos += BLOCK_SIZE) {
+        size_t length = std::min(BLOCK_SIZE, payload.size() - pos);
+        appendScalar<uint64_t>(blockChecksums, checksum(payload.data() + pos, length));
+    }
+    
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.tableCount = tableCount_;
+    header.payloadSize = payload.size();
+    header.checksum = checksum(payload.data(), payload.size());
+    
+    std::string file(reinterpret_cast<const char*>(&header), sizeof(header));
+    file += payload;
+    file += blockChecksums;
+    return file;
+}
+
+namespace {
+
+// 把文件内容刷到磁盘，而不仅是操作系统缓存
+bool flushToDisk(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// 持久化目录项本身，保证改名在断电后仍然生效（Windows上无需此步骤）
+void syncDirectory(const std::filesystem::path& directory) {
+#ifndef _WIN32
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        ::close(fd);
+    }
+#endif
+}
+
+} // namespace
+
+AtomicFile::AtomicFile(std::string path)
+    : path_(std::move(path)), tempPath_(path_ + ".tmp"), file_(std::fopen(tempPath_.c_str(), "wb")), ok_(file_ != nullptr) {}
+
+AtomicFile::~AtomicFile() {
+    if (file_) {
+        std::fclose(file_);
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+    }
+}
+
+bool AtomicFile::write(std::string_view data) {
+    ok_ = ok_ && std::fwrite(data.data(), 1, data.size(), file_) == data.size();
+    return ok_;
+}
+
+bool AtomicFile::commit(bool keepPrevious) {
+    if (!file_) {
+        return false;
+    }
+    bool written = flushToDisk(file_) && ok_;
+    written = (std::fclose(file_) == 0) && written;
+    file_ = nullptr;
+    
+    std::error_code ec;
+    if (!written) {
+        std::filesystem::remove(tempPath_, ec);
+        return false;
+    }
+    
+    // 旧文件先改名为.prev；两次改名之间崩溃时，恢复逻辑会回退到.prev
+    if (keepPrevious && std::filesystem::exists(path_, ec)) {
+        std::filesystem::rename(path_, path_ + ".prev", ec);
+        if (ec) {
+            return false;
+        }
+    }
+    std::filesystem::rename(tempPath_, path_, ec);
+    if (ec) {
+        return false;
+    }
+    syncDirectory(std::filesystem::path(path_).parent_path());
+    return true;
+}
+
+bool writeFileAtomically(const std::string& path, std::string_view content, bool keepPrevious) {
+    AtomicFile file(path);
+    return file.write(content) && file.commit(keepPrevious);
+}
+
+bool Writer::writeToFile(const std::string& path) const {
+    return writeFileAtomically(path, finish(), true);
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建立后即可关闭描述符
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data_) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(mappingHandle_);
+    CloseHandle(fileHandle_);
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+#else
+    munmap(const_cast<char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool Reader::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return fail("无法打开快照文件: " + path);
+    }
+    
+    // 一次顺序读入整个文件
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    buffer_.resize(static_cast<size_t>(size));
+    if (!file.read(buffer_.data(), size)) {
+        return fail("读取快照文件失败: " + path);
+    }
+    return parse(buffer_);
+}
+
+bool Reader::map(const std::string& path) {
+    if (!mapping_.open(path)) {
+        return fail("无法映射快照文件: " + path);
+    }
+    return parse(std::string_view(mapping_.data(), mapping_.size()), true);
+}
+
+bool Reader::parse(std::string_view bytes) {
+    return parse(bytes, false);
+}
+
+void Reader::verifyBlock(size_t block) const {
+    size_t begin = block * BLOCK_SIZE;
+    uint64_t expected = readScalar<uint64_t>(blockChecksums_ + block * sizeof(uint64_t));
+    if (checksum(payload_ + begin, std::min(BLOCK_SIZE, payloadSize_ - begin)) != expected) {
+        throw std::runtime_error("快照第" + std::to_string(block) + "块校验和不匹配");
+    }
+    blockVerified_[block].store(true, std::memory_order_release);
+}
+
+bool Reader::parse(std::string_view bytes, bool verifyByBlock) {
+    tables_.clear();
+    blockVerified_.reset();
+    
+    if (bytes.size() < sizeof(FileHeader)) {
+        return fail("快照文件过短");
+    }
+    FileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return fail("快照魔数不匹配");
+    }
+    if (header.version < 1 || header.version > FORMAT_VERSION) {
+        return fail("不支持的快照版本: " + std::to_string(header.version));
+    }
+    // 版本2起负载后面跟着每块的校验和
+    size_t available = bytes.size() - sizeof(FileHeader);
+    uint64_t blocks = header.version >= 2 ? (header.payloadSize + BLOCK_SIZE - 1) / BLOCK_SIZE : 0;
+    if (header.payloadSize > available || available - header.payloadSize != blocks * sizeof(uint64_t)) {
+        return fail("快照长度不匹配（文件可能被截断）");
+    }
+    
+    const char* payload = bytes.data() + sizeof(FileHeader);
+    size_t size = static_cast<size_t>(header.payloadSize);
+    payload_ = payload;
+    payloadSize_ = size;
+    blockChecksums_ = payload + size;
+    if (verifyByBlock && header.version >= 2) {
+        blockVerified_ = std::make_unique<std::atomic<bool>[]>(static_cast<size_t>(blocks));
+    } else if (checksum(payload, size) != header.checksum) {
+        return fail("快照校验和不匹配");
+    }
+    
+    // 建立目录：只记录各列的位置，不解码任何行。按块校验时，目录本身读到的字节先校验
+    size_t pos = 0;
+    auto need = [&](uint64_t n) { return n <= size - pos; };
+    auto take = [&](size_t n) {
+        const char* p = payload + pos;
+        verify(p, n);
+        pos += n;
+        return p;
+    };
+    auto readU32 = [&](uint32_t& out) {
+        if (!need(4)) return false;
+        out = readScalar<uint32_t>(take(4));
+        return true;
+    };
+    auto readName = [&](std::string_view& out) {
+        uint32_t length;
+        if (!readU32(length) || !need(length)) return false;
+        out = std::string_view(take(length), length);
+        return true;
+    };
+    
+    try {
+        if (!need(8)) return fail("快照缺少字符串堆");
+        uint64_t stringsSize = readScalar<uint64_t>(take(8));
+        if (!need(stringsSize)) return fail("快照字符串堆越界");
+        strings_ = std::string_view(payload + pos, static_cast<size_t>(stringsSize));
+        pos += static_cast<size_t>(stringsSize);
+        
+        if (!need(8)) return fail("快照缺少整数堆");
+        intCount_ = readScalar<uint64_t>(take(8));
+        if (intCount_ > (size - pos) / sizeof(int32_t)) return fail("快照整数堆越界");
+        ints_ = payload + pos;
+        pos += static_cast<size_t>(intCount_) * sizeof(int32_t);
+        
+        for (uint32_t t = 0; t < header.tableCount; ++t) {
+            Table table;
+            uint32_t columnCount;
+            if (!readName(table.name) || !readU32(table.rows) || !readU32(columnCount)) {
+                return fail("快照表头损坏");
+            }
+            for (uint32_t c = 0; c < columnCount; ++c) {
+                Column column;
+                if (!readName(column.name) || !need(1)) {
+                    return fail("快照列头损坏");
+                }
+                column.kind = static_cast<ColumnKind>(*take(1));
+                if (column.kind < ColumnKind::Integer || column.kind > ColumnKind::IntList) {
+                    return fail("未知的快照列类型");
+                }
+                uint64_t columnSize = static_cast<uint64_t>(table.rows) * columnWidth(column.kind);
+                if (!need(columnSize)) {
+                    return fail("快照列数据越界");
+                }
+                column.data = payload + pos;
+                pos += static_cast<size_t>(columnSize);
+                table.columns.push_back(column);
+            }
+            tables_.push_back(std::move(table));
+        }
+    } catch (const std::exception& e) {
+        return fail(e.what());
+    }
+    
+    error_.clear();
+    return true;
+}
+
+const Table* Reader::findTable(std::string_view name) const {
+    for (const auto& table : tables_) {
+        if (table.name == name) {
+            return &table;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace Snapshot
@@ -0,0 +1,534 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <tuple>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <type_traits>
+#include <bit>
+#include <algorithm>
+#include <future>
+#include <atomic>
+#include "json_codec.h"
+
+// 二进制快照格式：启动时一次顺序读入即可恢复全部用户、图书和借阅记录。
+//
+// 文件布局（小端）：
+//   FileHeader                         魔数、版本、表数量、负载长度、负载校验和
+//   u64 字符串堆长度 + 字节            所有字符串字段的内容
+//   u64 整数堆元素数 + int32[]         所有整数列表字段（如borrowHistory）的内容
+//   表 × tableCount：
+//     u32 名称长度 + 名称, u32 行数, u32 列数
+//     列 × 列数：u32 名称长度 + 名称, u8 类型, 行数 × 列宽 字节
+//   块校验和（版本2起）：负载按BLOCK_SIZE分块，每块一个u64校验和
+//
+// 一次读入时校验整个负载；映射时只在某一块首次被访问时校验该块，打开快照不必读遍整个文件。
+// 列直接由实体的 jsonFields() 字段表生成，列名与JSON键名一致；读取时按列名匹配，
+// 未知列被忽略，缺失列保持构造默认值。JSON文件仍作为导入/导出格式保留。
+namespace Snapshot {
+
+static_assert(std::endian::native == std::endian::little, "快照格式按小端字节序存储");
+
+constexpr char MAGIC[8] = {'L', 'I', 'B', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t FORMAT_VERSION = 2;
+// 映射读取时的校验粒度
+constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tableCount;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+static_assert(sizeof(FileHeader) == 32, "FileHeader必须是固定布局");
+
+enum class ColumnKind : uint8_t {
+    Integer = 1,   // int64
+    Boolean = 2,   // uint8
+    String = 3,    // uint32 偏移 + uint32 长度，指向字符串堆
+    IntList = 4    // uint32 起始下标 + uint32 元素数，指向整数堆
+};
+
+inline size_t columnWidth(ColumnKind kind) {
+    return kind == ColumnKind::Boolean ? 1 : 8;
+}
+
+template <typename T>
+constexpr ColumnKind columnKindOf() {
+    if constexpr (std::is_same_v<T, bool>) return ColumnKind::Boolean;
+    else if constexpr (std::is_integral_v<T>) return ColumnKind::Integer;
+    else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, Symbol>) return ColumnKind::String;
+    else return ColumnKind::IntList;
+}
+
+// 负载校验和（按8字节分组的FNV-1a变体）
+uint64_t checksum(const char* data, size_t size);
+
+// 崩溃安全的整文件写入：写临时文件并fsync后改名替换目标。
+// 任何时刻目标路径上要么是旧的完整文件，要么是新的完整文件。
+// keepPrevious为true时，被替换的旧文件保留为 path + ".prev"
+bool writeFileAtomically(const std::string& path, std::string_view content, bool keepPrevious = false);
+
+// 分块写入的同一机制：内容可以分多次write()，不必先在内存中拼出整个文件。
+// commit()刷盘后原子替换目标；没有commit就析构（或任何一次写入失败）时删除临时文件，目标保持不变
+class AtomicFile {
+public:
+    explicit AtomicFile(std::string path);
+    ~AtomicFile();
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+    
+    bool write(std::string_view data);
+    bool commit(bool keepPrevious = false);
+
+private:
+    std::string path_;
+    std::string tempPath_;
+    std::FILE* file_;
+    bool ok_;
+};
+
+struct Column {
+    std::string_view name;
+    ColumnKind kind;
+    const char* data;
+};
+
+struct Table {
+    std::string_view name;
+    uint32_t rows;
+    std::vector<Column> columns;
+};
+
+class Writer;
+class Reader;
+
+// 逐行构建一张表：每个字段一列，字符串和整数列表写入所属Writer的堆
+template <typename T>
+class TableBuilder {
+public:
+    static constexpr size_t FIELD_COUNT = std::tuple_size_v<decltype(T::jsonFields())>;
+    
+    TableBuilder(Writer& writer, std::string_view name) : writer_(writer), name_(name), rows_(0) {}
+    
+    void add(const T& obj) {
+        size_t index = 0;
+        std::apply([&](const auto&... fields) { (appendCell(columns_[index++], obj, fields), ...); },
+                   T::jsonFields());
+        ++rows_;
+    }
+    
+    // 从另一份快照原样复制一行，不解码成实体；columns为源表按 T::jsonFields() 绑定的列
+    void copyRow(const Reader& reader, const std::vector<const Column*>& columns, uint32_t row);
+    
+    // 把已积累的列追加到Writer中
+    void finish();
+
+private:
+    template <typename Field>
+    void appendCell(std::string& column, const T& obj, const Field& field);
+    template <typename Field>
+    void copyCell(std::string& column, const Reader& reader, const Column* source, uint32_t row, const Field& field);
+    
+    Writer& writer_;
+    std::string name_;
+    uint32_t rows_;
+    std::string columns_[FIELD_COUNT];
+    // 源字符串堆中符号文本的位置（偏移<<32|长度）-> 本快照中的偏移，每个符号只驻留一次
+    std::unordered_map<uint64_t, uint32_t> copiedSymbols_;
+};
+
+// 快照写入器：逐表追加，最后组装成完整文件
+class Writer {
+public:
+    Writer() : tableCount_(0) {}
+    
+    template <typename Range>
+    void addTable(std::string_view name, const Range& items) {
+        using T = std::remove_cvref_t<decltype(**std::begin(items))>;
+        TableBuilder<T> table(*this, name);
+        for (const auto& item : items) {
+            table.add(*item);
+        }
+        table.finish();
+    }
+    
+    // 组装完整的文件内容（文件头 + 负载 + 块校验和）
+    std::string finish() const;
+    
+    // 原子替换快照文件，上一份快照保留为 path + ".prev" 供恢复使用。
+    // 读者（包括映射着旧文件的进程）不会看到写了一半的快照
+    bool writeToFile(const std::string& path) const;
+
+private:
+    template <typename T>
+    friend class TableBuilder;
+    
+    template <typename T>
+    static void appendScalar(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    
+    static void appendName(std::string& out, std::string_view name) {
+        appendScalar<uint32_t>(out, static_cast<uint32_t>(name.length()));
+        out.append(name);
+    }
+    
+    static uint32_t heapOffset(size_t offset) {
+        if (offset > UINT32_MAX) {
+            throw std::length_error("快照堆超过4GB");
+        }
+        return static_cast<uint32_t>(offset);
+    }
+    
+    // 符号文本在字符串堆中的偏移；每个符号在一份快照中只写入一次
+    uint32_t symbolOffset(Symbol symbol);
+    
+    static constexpr uint32_t NOT_WRITTEN = UINT32_MAX;
+    
+    std::string strings_;
+    std::vector<int32_t> ints_;
+    std::vector<uint32_t> symbolOffsets_; // 按符号id索引，NOT_WRITTEN表示还没写过
+    std::string tables_;
+    uint32_t tableCount_;
+};
+
+template <typename T>
+template <typename Field>
+void TableBuilder<T>::appendCell(std::string& column, const T& obj, const Field& field) {
+    using Value = typename Field::value_type;
+    constexpr ColumnKind kind = columnKindOf<Value>();
+    const Value& value = obj.*(field.member);
+    if constexpr (kind == ColumnKind::Boolean) {
+        column += static_cast<char>(value ? 1 : 0);
+    } else if constexpr (kind == ColumnKind::Integer) {
+        Writer::appendScalar<int64_t>(column, static_cast<int64_t>(value));
+    } else if constexpr (std::is_same_v<Value, Symbol>) {
+        // 同一符号的文本在字符串堆中只写一次，各行共用偏移
+        Writer::appendScalar<uint32_t>(column, writer_.symbolOffset(value));
+        Writer::appendScalar<uint32_t>(column, static_cast<uint32_t>(value.str().size()));
+    } else if constexpr (kind == ColumnKind::String) {
+        Writer::appendScalar<uint32_t>(column, Writer::heapOffset(writer_.strings_.size()));
+        Writer::appendScalar<uint32_t>(column, static_cast<uint32_t>(value.size()));
+        writer_.strings_ += value;
+    } else {
+        Writer::appendScalar<uint32_t>(column, Writer::heapOffset(writer_.ints_.size()));
+        Writer::appendScalar<uint32_t>(column, static_cast<uint32_t>(value.size()));
+        writer_.ints_.insert(writer_.ints_.end(), value.begin(), value.end());
+    }
+}
+
+template <typename T>
+void TableBuilder<T>::finish() {
+    std::string& out = writer_.tables_;
+    Writer::appendName(out, name_);
+    Writer::appendScalar<uint32_t>(out, rows_);
+    Writer::appendScalar<uint32_t>(out, static_cast<uint32_t>(FIELD_COUNT));
+    
+    size_t index = 0;
+    auto appendColumn = [&](const auto& field) {
+        using Value = typename std::remove_cvref_t<decltype(field)>::value_type;
+        Writer::appendName(out, field.name);
+        out += static_cast<char>(columnKindOf<Value>());
+        out += columns_[index++];
+    };
+    std::apply([&](const auto&... fields) { (appendColumn(fields), ...); }, T::jsonFields());
+    ++writer_.tableCount_;
+}
+
+// 只读内存映射文件
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool open(const std::string& path);
+    void close();
+    
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+};
+
+// 快照读取器：校验文件头和校验和后建立表目录，按需把行解码成实体
+class Reader {
+public:
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+    
+    // 一次顺序读入整个文件并校验；失败时返回false，error()给出原因
+    bool load(const std::string& path);
+    
+    // 以内存映射方式打开快照。打开时只校验表目录所在的块，其余各块在首次被访问时才校验，
+    // 打开耗时和常驻内存都不随文件大小增长；之后的访问遇到损坏的块时抛出std::runtime_error。
+    // 版本1的快照没有块校验和，打开时校验整个负载
+    bool map(const std::string& path);
+    
+    // 解析一段已在内存中的快照并校验整个负载（数据须在Reader生命周期内有效）
+    bool parse(std::string_view bytes);
+    
+    const std::string& error() const { return error_; }
+    const Table* findTable(std::string_view name) const;
+    std::string_view stringHeap() const { return strings_; }
+    
+    // 按字段表把列绑定到字段：结果与 T::jsonFields() 一一对应，缺失或类型不符时为nullptr
+    template <typename T>
+    std::vector<const Column*> bindColumns(const Table& table) const {
+        std::vector<const Column*> bound;
+        std::apply([&](const auto&... fields) { (bound.push_back(bindColumn(table, fields)), ...); },
+                   T::jsonFields());
+        return bound;
+    }
+    
+    // 单元格的原始字节（列宽个字节）；映射时先校验所在的块。
+    // 以下按单元格读取的方法都经过这里，不解码整行
+    const char* cellAt(const Column& column, uint32_t row) const {
+        size_t width = columnWidth(column.kind);
+        const char* cell = column.data + static_cast<size_t>(row) * width;
+        verify(cell, width);
+        return cell;
+    }
+    
+    // 读取整数列中的单个单元格
+    int64_t integerAt(const Column& column, uint32_t row) const {
+        return readScalar<int64_t>(cellAt(column, row));
+    }
+    
+    // 把整数列表列中单个单元格的元素追加到out
+    void appendIntsAt(const Column& column, uint32_t row, std::vector<int32_t>& out) const {
+        const char* cell = cellAt(column, row);
+        uint32_t count = readScalar<uint32_t>(cell + 4);
+        const char* ints = heapInts(readScalar<uint32_t>(cell), count);
+        size_t base = out.size();
+        out.resize(base + count);
+        if (count > 0) {
+            std::memcpy(out.data() + base, ints, count * sizeof(int32_t));
+        }
+    }
+    
+    // 读取字符串列中的单个单元格，返回指向字符串堆的视图
+    std::string_view stringAt(const Column& column, uint32_t row) const {
+        const char* cell = cellAt(column, row);
+        return heapString(readScalar<uint32_t>(cell), readScalar<uint32_t>(cell + 4));
+    }
+    
+    template <typename T>
+    void decodeRow(const std::vector<const Column*>& columns, uint32_t row, T& obj) const {
+        size_t index = 0;
+        std::apply([&](const auto&... fields) { (decodeField(columns[index++], row, obj, fields), ...); },
+                   T::jsonFields());
+        Json::finishRead(obj);
+    }
+    
+    // 把整张表解码成实体；表不存在时out保持为空。
+    // 行数足够多时按行区间切分，最多用maxThreads个线程并行解码（各线程只写自己的区间）
+    template <typename T>
+    void readTable(std::string_view name, std::vector<std::unique_ptr<T>>& out, unsigned maxThreads = 1) const {
+        const Table* table = findTable(name);
+        if (!table) return;
+        auto columns = bindColumns<T>(*table);
+        size_t base = out.size();
+        out.resize(base + table->rows);
+        
+        auto decodeRange = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t row = begin; row < end; ++row) {
+                auto obj = std::make_unique<T>();
+                decodeRow(columns, row, *obj);
+                out[base + row] = std::move(obj);
+            }
+        };
+        uint32_t threads = std::clamp<uint32_t>(table->rows / MIN_ROWS_PER_THREAD, 1, std::max(1u, maxThreads));
+        uint32_t chunk = (table->rows + threads - 1) / threads;
+        std::vector<std::future<void>> tasks;
+        for (uint32_t t = 1; t < threads; ++t) {
+            uint32_t begin = std::min(table->rows, t * chunk);
+            tasks.push_back(std::async(std::launch::async, decodeRange, begin, std::min(table->rows, begin + chunk)));
+        }
+        decodeRange(0, std::min(table->rows, chunk));
+        for (auto& task : tasks) {
+            task.get();
+        }
+    }
+
+private:
+    static constexpr uint32_t MIN_ROWS_PER_THREAD = 8192;
+    
+    template <typename T>
+    static T readScalar(const char* p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+    
+    template <typename Field>
+    const Column* bindColumn(const Table& table, const Field& field) const {
+        using Value = typename Field::value_type;
+        for (const auto& column : table.columns) {
+            if (column.name == field.name) {
+                return column.kind == columnKindOf<Value>() ? &column : nullptr;
+            }
+        }
+        return nullptr;
+    }
+    
+    // 缺失列取默认构造对象中的值，解码到复用的对象时也不会残留上一行的内容
+    template <typename T>
+    static const T& defaults() {
+        static const T value{};
+        return value;
+    }
+    
+    template <typename T, typename Field>
+    void decodeField(const Column* column, uint32_t row, T& obj, const Field& field) const {
+        using Value = typename Field::value_type;
+        Value& value = obj.*(field.member);
+        if (!column) {
+            value = defaults<T>().*(field.member);
+            return;
+        }
+        const char* cell = cellAt(*column, row);
+        if constexpr (std::is_same_v<Value, bool>) {
+            value = *cell != 0;
+        } else if constexpr (std::is_integral_v<Value>) {
+            value = static_cast<Value>(readScalar<int64_t>(cell));
+        } else if constexpr (std::is_same_v<Value, std::string> || std::is_same_v<Value, Symbol>) {
+            std::string_view text = heapString(readScalar<uint32_t>(cell), readScalar<uint32_t>(cell + 4));
+            if constexpr (std::is_same_v<Value, Symbol>) {
+                value = Symbol(text);
+            } else {
+                value.assign(text.data(), text.size());
+            }
+        } else {
+            uint32_t count = readScalar<uint32_t>(cell + 4);
+            const char* ints = heapInts(readScalar<uint32_t>(cell), count);
+            value.resize(count);
+            if (count > 0) {
+                std::memcpy(value.data(), ints, count * sizeof(int32_t));
+            }
+        }
+    }
+    
+    std::string_view heapString(uint32_t offset, uint32_t length) const {
+        if (static_cast<uint64_t>(offset) + length > strings_.size()) {
+            throw std::out_of_range("快照字符串越界");
+        }
+        verify(strings_.data() + offset, length);
+        return strings_.substr(offset, length);
+    }
+    
+    const char* heapInts(uint32_t offset, uint32_t count) const {
+        if (static_cast<uint64_t>(offset) + count > intCount_) {
+            throw std::out_of_range("快照整数列表越界");
+        }
+        const char* ints = ints_ + static_cast<size_t>(offset) * sizeof(int32_t);
+        verify(ints, count * sizeof(int32_t));
+        return ints;
+    }
+    
+    // 映射时校验[data, data+size)覆盖的块；每块只校验一次，已整体校验过时直接返回
+    void verify(const char* data, size_t size) const {
+        if (!blockVerified_ || size == 0) {
+            return;
+        }
+        size_t first = static_cast<size_t>(data - payload_) / BLOCK_SIZE;
+        size_t last = static_cast<size_t>(data + size - 1 - payload_) / BLOCK_SIZE;
+        for (size_t block = first; block <= last; ++block) {
+            if (!blockVerified_[block].load(std::memory_order_acquire)) {
+                verifyBlock(block);
+            }
+        }
+    }
+    void verifyBlock(size_t block) const;
+    
+    bool parse(std::string_view bytes, bool verifyByBlock);
+    
+    bool fail(const std::string& message) {
+        error_ = message;
+        return false;
+    }
+    
+    std::string buffer_;
+    MappedFile mapping_;
+    std::string_view strings_;
+    const char* ints_ = nullptr;
+    uint64_t intCount_ = 0;
+    std::vector<Table> tables_;
+    std::string error_;
+    
+    // 按块校验（仅映射版本2的快照时使用）：负载起点、尾部的块校验和、各块是否已校验。
+    // 多个线程可能同时校验同一块，结果相同，只是重复计算
+    const char* payload_ = nullptr;
+    size_t payloadSize_ = 0;
+    const char* blockChecksums_ = nullptr;
+    std::unique_ptr<std::atomic<bool>[]> blockVerified_;
+};
+
+template <typename T>
+void TableBuilder<T>::copyRow(const Reader& reader, const std::vector<const Column*>& columns, uint32_t row) {
+    size_t index = 0;
+    std::apply([&](const auto&... fields) {
+        ((copyCell(columns_[index], reader, columns[index], row, fields), ++index), ...);
+    }, T::jsonFields());
+    ++rows_;
+}
+
+template <typename T>
+template <typename Field>
+void TableBuilder<T>::copyCell(std::string& column, const Reader& reader, const Column* source, uint32_t row,
+                               const Field& field) {
+    using Value = typename Field::value_type;
+    constexpr ColumnKind kind = columnKindOf<Value>();
+    if (!source) {
+        // 源表缺这一列：与解码时一样取默认构造对象中的值
+        static const T defaults{};
+        appendCell(column, defaults, field);
+        return;
+    }
+    if constexpr (kind == ColumnKind::Boolean || kind == ColumnKind::Integer) {
+        // 经过cellAt按块校验：损坏的内容不会被复制进新快照并配上新的校验和
+        column.append(reader.cellAt(*source, row), columnWidth(kind));
+    } else if constexpr (kind == ColumnKind::String) {
+        std::string_view text = reader.stringAt(*source, row);
+        uint32_t offset;
+        if constexpr (std::is_same_v<Value, Symbol>) {
+            uint64_t key = (static_cast<uint64_t>(text.data() - reader.stringHeap().data()) << 32) | text.size();
+            auto [it, inserted] = copiedSymbols_.try_emplace(key, 0);
+            if (inserted) {
+                it->second = writer_.symbolOffset(Symbol(text));
+            }
+            offset = it->second;
+        } else {
+            offset = Writer::heapOffset(writer_.strings_.size());
+            writer_.strings_ += text;
+        }
+        Writer::appendScalar<uint32_t>(column, offset);
+        Writer::appendScalar<uint32_t>(column, static_cast<uint32_t>(text.size()));
+    } else {
+        Writer::appendScalar<uint32_t>(column, Writer::heapOffset(writer_.ints_.size()));
+        size_t before = writer_.ints_.size();
+        reader.appendIntsAt(*source, row, writer_.ints_);
+        Writer::appendScalar<uint32_t>(column, static_cast<uint32_t>(writer_.ints_.size() - before));
+    }
+}
+
+} // namespace Snapshot
+
+#endif // SNAPSHOT_H
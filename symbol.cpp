@@ -0,0 +1,80 @@
+#include "symbol.h"
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <algorithm>
+#include <cctype>
+
+// 进程内唯一的驻留表。条目放在deque中，追加时已有条目的地址不变，Symbol可以直接持有指针
+class SymbolTable {
+public:
+    using Entry = Symbol::Entry;
+    
+    static SymbolTable& instance() {
+        static SymbolTable table;
+        return table;
+    }
+    
+    const Entry* empty() const { return empty_; }
+    
+    const Entry* intern(std::string_view text) {
+        if (text.empty()) {
+            return empty_;
+        }
+        {
+            // 绝大多数调用命中已有条目，只需共享锁
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = index_.find(text);
+            if (it != index_.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = index_.find(text);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        const Entry* entry = add(text);
+        index_.emplace(entry->text, entry);
+        return entry;
+    }
+    
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return entries_.size();
+    }
+    
+    const Entry* at(uint32_t id) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return &entries_.at(id);
+    }
+
+private:
+    SymbolTable() : empty_(add("")) {}
+    
+    const Entry* add(std::string_view text) {
+        std::string lower(text);
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        entries_.push_back(Entry{std::string(text), std::move(lower), static_cast<uint32_t>(entries_.size())});
+        return &entries_.back();
+    }
+    
+    mutable std::shared_mutex mutex_;
+    std::deque<Entry> entries_;
+    std::unordered_map<std::string_view, const Entry*> index_; // 键指向条目自身的text
+    const Entry* empty_;
+};
+
+Symbol::Symbol() : entry_(SymbolTable::instance().empty()) {}
+
+Symbol::Symbol(std::string_view text) : entry_(SymbolTable::instance().intern(text)) {}
+
+size_t Symbol::count() {
+    return SymbolTable::instance().size();
+}
+
+Symbol Symbol::fromId(uint32_t id) {
+    return Symbol(SymbolTable::instance().at(id));
+}
@@ -0,0 +1,47 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// 驻留字符串：作者、分类这类重复度高的字段，相同的文本在进程内只存一份。
+//
+// Symbol只有一个指针大小，指向驻留表中的条目；判断相等只比较指针，id()从0开始连续编号，
+// 可以直接作为计数数组的下标做分面统计。条目驻留后不再释放，所以不用于书名、简介这类自由文本。
+// 驻留（从文本构造）时加锁，读取文本和id不加锁，多个线程可以同时解码。
+class Symbol {
+public:
+    // 空串，id为0
+    Symbol();
+    explicit Symbol(std::string_view text);
+    
+    const std::string& str() const { return entry_->text; }
+    // 小写形式，关键字匹配时不必每次转换
+    const std::string& lower() const { return entry_->lower; }
+    uint32_t id() const { return entry_->id; }
+    bool empty() const { return entry_->text.empty(); }
+    
+    bool operator==(const Symbol& other) const { return entry_ == other.entry_; }
+    bool operator!=(const Symbol& other) const { return entry_ != other.entry_; }
+    
+    // 已驻留的文本数（含空串），所有id都小于它
+    static size_t count();
+    // id必须小于count()
+    static Symbol fromId(uint32_t id);
+
+private:
+    struct Entry {
+        std::string text;
+        std::string lower;
+        uint32_t id;
+    };
+    friend class SymbolTable;
+    
+    explicit Symbol(const Entry* entry) : entry_(entry) {}
+    
+    const Entry* entry_;
+};
+
+#endif // SYMBOL_H
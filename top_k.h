@@ -0,0 +1,76 @@
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <unordered_map>
+#include <set>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+// 计数器 + 增量维护的前K名。
+//
+// 计数只增不减，因此可以保持这样的不变式：不在前K名集合中的键，计数都不超过集合中的最小值。
+// 每次累加只需把该键与集合中的最小值比较，O(log K)；取前n名（n <= K）是O(n)。
+class TopKCounter {
+public:
+    explicit TopKCounter(size_t capacity) : capacity_(capacity) {}
+    
+    void add(int key, int delta = 1) {
+        int& count = counts_[key];
+        int previous = count;
+        count += delta;
+        
+        auto it = top_.find({previous, key});
+        if (it != top_.end()) {
+            top_.erase(it);
+            top_.insert({count, key});
+        } else if (top_.size() < capacity_) {
+            top_.insert({count, key});
+        } else if (count > top_.begin()->first) {
+            top_.erase(top_.begin());
+            top_.insert({count, key});
+        }
+    }
+    
+    // 按计数降序返回前n名；n超过容量时退化为对全部计数做部分排序
+    std::vector<std::pair<int, int>> top(size_t n) const {
+        std::vector<std::pair<int, int>> result;
+        if (n <= capacity_) {
+            for (auto it = top_.rbegin(); it != top_.rend() && result.size() < n; ++it) {
+                result.emplace_back(it->second, it->first);
+            }
+            return result;
+        }
+        
+        result.assign(counts_.begin(), counts_.end());
+        auto byCount = [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        };
+        n = std::min(n, result.size());
+        std::partial_sort(result.begin(), result.begin() + n, result.end(), byCount);
+        result.resize(n);
+        return result;
+    }
+    
+    const std::unordered_map<int, int>& counts() const { return counts_; }
+    size_t capacity() const { return capacity_; }
+    
+    void clear() {
+        counts_.clear();
+        top_.clear();
+    }
+
+private:
+    // (计数, 键)，begin()是集合中计数最小的一项
+    struct Order {
+        bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const {
+            return a.first != b.first ? a.first < b.first : a.second > b.second;
+        }
+    };
+    
+    size_t capacity_;
+    std::unordered_map<int, int> counts_;
+    std::set<std::pair<int, int>, Order> top_;
+};
+
+#endif // TOP_K_H
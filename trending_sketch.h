@@ -0,0 +1,119 @@
+#ifndef TRENDING_SKETCH_H
+#define TRENDING_SKETCH_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+
+// 带指数衰减的Space-Saving热门统计：用固定数量的计数器近似"最近一段时间借得最多"的键。
+//
+// 每次事件的权重是 2^((事件时间 - 基准时间) / 半衰期)，越新的事件权重越大，
+// 查询时统一换算到当前时刻，相当于每过一个半衰期所有得分减半，而无需逐个衰减计数器。
+// 计数器已满时新键顶替得分最小的计数器并继承其得分（记为误差上界），
+// 因此得分只会高估，且高估量不超过 error；真实得分超过 总权重/容量 的键一定在表中。
+class TrendingSketch {
+public:
+    struct Entry {
+        int key;
+        double score;  // 换算到查询时刻的衰减借阅次数
+        double error;  // score的高估上界
+    };
+    
+    TrendingSketch(size_t capacity, int64_t halfLife, std::time_t landmark)
+        : capacity_(capacity), halfLife_(static_cast<double>(halfLife)), landmark_(landmark) {
+        counters_.reserve(capacity);
+        index_.reserve(capacity);
+    }
+    
+    void add(int key, std::time_t time, double count = 1.0) {
+        double exponent = static_cast<double>(time - landmark_) / halfLife_;
+        if (exponent > MAX_EXPONENT) {
+            rebase(time);
+            exponent = 0;
+        }
+        insert(key, count * std::exp2(exponent), 0.0);
+    }
+    
+    // 合并另一份同规格的草图（基准时间可以不同）
+    void merge(const TrendingSketch& other) {
+        double scale = std::exp2(static_cast<double>(other.landmark_ - landmark_) / halfLife_);
+        for (const Counter& counter : other.counters_) {
+            insert(counter.key, counter.weight * scale, counter.error * scale);
+        }
+    }
+    
+    // 按当前得分降序返回前n个
+    std::vector<Entry> top(size_t n, std::time_t now) const {
+        double scale = std::exp2(static_cast<double>(landmark_ - now) / halfLife_);
+        std::vector<Entry> result;
+        result.reserve(counters_.size());
+        for (const Counter& counter : counters_) {
+            result.push_back({counter.key, counter.weight * scale, counter.error * scale});
+        }
+        auto byScore = [](const Entry& a, const Entry& b) {
+            return a.score != b.score ? a.score > b.score : a.key < b.key;
+        };
+        n = std::min(n, result.size());
+        std::partial_sort(result.begin(), result.begin() + n, result.end(), byScore);
+        result.resize(n);
+        return result;
+    }
+    
+    size_t capacity() const { return capacity_; }
+    
+    void clear() {
+        counters_.clear();
+        index_.clear();
+    }
+
+private:
+    // 权重超过2^MAX_EXPONENT时把基准时间移到当前事件，防止溢出
+    static constexpr double MAX_EXPONENT = 512.0;
+    
+    struct Counter {
+        int key;
+        double weight;
+        double error;
+    };
+    
+    void insert(int key, double weight, double error) {
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            Counter& counter = counters_[it->second];
+            counter.weight += weight;
+            counter.error += error;
+            return;
+        }
+        if (counters_.size() < capacity_) {
+            index_.emplace(key, counters_.size());
+            counters_.push_back({key, weight, error});
+            return;
+        }
+        // 顶替得分最小的计数器；容量很小（几十个），线性扫描比维护堆更快
+        auto smallest = std::min_element(counters_.begin(), counters_.end(),
+                                         [](const Counter& a, const Counter& b) { return a.weight < b.weight; });
+        index_.erase(smallest->key);
+        index_.emplace(key, static_cast<size_t>(smallest - counters_.begin()));
+        *smallest = {key, smallest->weight + weight, smallest->weight + error};
+    }
+    
+    void rebase(std::time_t landmark) {
+        double scale = std::exp2(static_cast<double>(landmark_ - landmark) / halfLife_);
+        for (Counter& counter : counters_) {
+            counter.weight *= scale;
+            counter.error *= scale;
+        }
+        landmark_ = landmark;
+    }
+    
+    size_t capacity_;
+    double halfLife_;
+    std::time_t landmark_;
+    std::vector<Counter> counters_;
+    std::unordered_map<int, size_t> index_;  // 键 -> counters_中的位置
+};
+
+#endif // TRENDING_SKETCH_H